@@ -20,7 +20,29 @@
 #include <sysexits.h>
 #include <unistd.h>
 #include <ctype.h>
+#include <stdint.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <limits.h>
+#include <time.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <pthread.h>
+#include <setjmp.h>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "fucked-up.h"
+#include "superinstructions.h"
 
 // Error codes
 enum {
@@ -32,420 +54,5454 @@ enum {
     STATUS_NO_INPUT,
     // Running
     STATUS_CANNOT_REACH_GCC,
+    STATUS_JIT_UNSUPPORTED,
+    STATUS_CANNOT_MAP_MEMORY,
+    STATUS_CANNOT_REACH_LLVM,
+    STATUS_LLVM_TOO_NEW,
+    STATUS_COMMAND_FAILED,
+    STATUS_LEFT_TAPE,
+    STATUS_SUSPENDED,
+    STATUS_NEEDS_INPUT,
+    STATUS_OVER_QUOTA,
     // Temporary file
     STATUS_CANNOT_CREATE_TEMP_FILE,
+    // Profile file
+    STATUS_CANNOT_READ_PROFILE,
+    STATUS_CANNOT_WRITE_PROFILE,
+    // Snapshot file
+    STATUS_CANNOT_READ_SNAPSHOT,
+    STATUS_CANNOT_WRITE_SNAPSHOT,
+    // Batches
+    STATUS_CANNOT_READ_MANIFEST,
+    STATUS_CANNOT_OPEN_JOB_FILE,
+};
+
+/* Instructions, working on the cell at OFFSET from the memory pointer
+   with argument ARG as described. Until `lower` every OFFSET is 0. */
+enum {
+    BF_END = 0,    // Ends instruction space
+    BF_ADD,        // Adds ARG to the cell
+    BF_MOVE,       // Moves the memory pointer by ARG cells
+    BF_GET,        // Reads a byte of input into the cell
+    BF_PUT,        // Writes the cell to the output
+    BF_LOOP_START, // ARG is the index of the matching BF_LOOP_END
+    BF_LOOP_END,   // ARG is the index of the matching BF_LOOP_START
+    // Only produced by `peephole`
+    BF_CLEAR,      // Sets the cell to 0
+    BF_SCAN,       // Moves the memory pointer by ARG until it is on a 0
+    BF_MUL_ADD,    // Adds the cell times the ARG of each of the ARG
+                   // BF_TERMs after it to the cell at their OFFSET, then
+                   // sets it to 0. Nothing happens if it is 0 already.
+    // Only produced by `constants`
+    BF_SET,        // Sets the cell to ARG
+    BF_WRITE,      // Writes the ARG bytes that are the ARG of the BF_TERMs
+                   // after it
+    // Only produced by `lower`
+    BF_PUT_RUN,    // Writes the cells of the ARG BF_TERMs after it
+    // Only produced by `bounds`
+    BF_FIT,        // Makes sure the tape reaches ARG cells past the pointer
+    BF_TERM,       // Operand of the instruction before it, never run itself
+    BF_OPCODES,    // Number of the instructions above
+};
+
+/* One instruction in instruction space. FLAGS are free for passes to mark
+   instructions with, OFFSET and ARG are as described with the opcodes. */
+typedef struct {
+    uint8_t op;
+    uint8_t flags;
+    int16_t offset;
+    int32_t arg;
+} bf_op_t;
+
+// FLAGS of a BF_LOOP_START, set by `profile_apply`
+enum {
+    BF_FLAG_HOT = 1,  // Runs much of the program and goes around many times
+    BF_FLAG_COLD = 2, // Was never entered
+};
+
+// FLAGS of any instruction, set by `bounds`
+enum {
+    BF_FLAG_BOUNDED = 4, // Its cells are known to be on the tape already
+};
+
+// Whether an OFFSET fits in a bf_op_t
+#define BF_OFFSET_FITS(offset) ((offset) >= INT16_MIN && (offset) <= INT16_MAX)
+
+// Input Modes
+enum {
+    READ_FILE,
+    READ_ARG,
+    READ_STDIN,
+};
+
+// Tape Modes
+enum {
+    TAPE_DYNAMIC, // Grown with realloc, checked on every move
+    TAPE_GUARDED, // Fixed size between guard pages, never checked
+    TAPE_BOUNDED, // Fixed to the `tape_cells` the program needs, never checked
+    TAPE_FIXED,   // Given by the caller, checked on every move, never grown
+};
+
+// What BF_GET stores at the end of input, as in fucked-up.h
+enum {
+    EOF_MINUS_ONE = FUCKED_UP_EOF_MINUS_ONE, // All ones, like getchar's EOF
+    EOF_ZERO = FUCKED_UP_EOF_ZERO,
+    EOF_UNCHANGED = FUCKED_UP_EOF_UNCHANGED, // Leaves the cell as it was
+};
+
+// Output Modes
+enum {
+    WRITE_FILE,
+    WRITE_STDOUT,
+};
+
+// Interpreters used for GOAL_EVAL
+enum {
+    ENGINE_SWITCH,
+    ENGINE_THREADED,
+    ENGINE_TIERED,
+};
+
+// Goals
+enum {
+    GOAL_EVAL,
+    GOAL_GCC,
+    GOAL_LLVM,
+    GOAL_JIT,
+    GOAL_BENCH,
+    GOAL_PROFILE,
+    GOAL_SEQUENCES,
+};
+
+// Where in the source code an instruction came from, counting from 1
+typedef struct {
+    uint32_t line;
+    uint32_t column;
+} bf_position_t;
+
+// Container for all the program data
+typedef struct {
+    bf_op_t * ops; // Instruction space, ending in a BF_END
+    size_t length; // Number of instructions before the BF_END
+    size_t cell_size; // Bytes per cell on the tape, 1, 2 or 4
+    int tape_mode;
+    int line_buffered; // Write output at every newline, even if not a terminal
+    int eof; // What BF_GET does at the end of input, EOF_MINUS_ONE and on
+    // Position of every instruction, only kept up by the passes if not NULL
+    bf_position_t *positions;
+    size_t tape_cells; // Cells `bounds` proved the program stays in, or 0
+} bf_data_t;
+
+// Maps brainfuck instructions to bf_op_t, anything else, a comment, to BF_END
+static const bf_op_t bf_instructions[256] = {
+    ['+'] = {BF_ADD, 0, 0, 1},
+    ['-'] = {BF_ADD, 0, 0, -1},
+    [','] = {BF_GET, 0, 0, 0},
+    ['.'] = {BF_PUT, 0, 0, 0},
+    ['>'] = {BF_MOVE, 0, 0, 1},
+    ['<'] = {BF_MOVE, 0, 0, -1},
+    ['['] = {BF_LOOP_START, 0, 0, 0},
+    [']'] = {BF_LOOP_END, 0, 0, 0},
+};
+
+/* Source code of a program, either mapped straight from its file or read
+   into `buffer` when it cannot be mapped, like a pipe */
+typedef struct {
+    const char *text;
+    size_t length;
+    void *mapping;
+    char *buffer;
+} source_t;
+
+// Size of the blocks source that cannot be mapped is read in
+#define SOURCE_BLOCK_SIZE ((size_t) 1 << 20)
+
+// Size of the parts a mapped source is read and then given back in
+#define SOURCE_WINDOW_SIZE ((size_t) 1 << 24)
+
+int source_open (source_t *source, int fd)
+{
+    source->mapping = NULL;
+    source->buffer = NULL;
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0){
+        void *mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED){
+            // Pages that were read can be dropped again
+            madvise(mapping, info.st_size, MADV_SEQUENTIAL);
+            source->mapping = mapping;
+            source->text = mapping;
+            source->length = info.st_size;
+            return STATUS_OK;
+        }
+    }
+
+    size_t max = 0;
+    source->length = 0;
+    for (;;){
+        if (source->length + SOURCE_BLOCK_SIZE > max){
+            max = max ? max * 2 : SOURCE_BLOCK_SIZE;
+            source->buffer = realloc(source->buffer, max);
+        }
+        ssize_t got = read(fd, source->buffer + source->length,
+                           max - source->length);
+        if (got == -1 && errno == EINTR)
+            continue;
+        if (got == -1){
+            free(source->buffer);
+            return STATUS_NO_INPUT;
+        }
+        if (got == 0)
+            break;
+        source->length += got;
+    }
+    source->text = source->buffer;
+    return STATUS_OK;
+}
+
+void source_close (source_t *source)
+{
+    if (source->mapping != NULL)
+        munmap(source->mapping, source->length);
+    free(source->buffer);
+}
+
+/* State while `bf_data_from_source` builds instruction space, which grows
+   by doubling as it does not know how much will be needed */
+typedef struct {
+    bf_op_t *ops;
+    size_t length;
+    size_t max;
+    // Offset in the source of every instruction, if wanted
+    size_t *sources;
+    // Positions of the BF_LOOP_STARTs not closed yet, innermost last
+    int *open_loops;
+    size_t depth;
+    size_t max_depth;
+} loading_t;
+
+/* Adds one instruction to instruction space, merging runs of BF_ADDs and
+   of BF_MOVEs into one and dropping them if they cancel out. Loop
+   constructs get the index of the one matching them. `at` is where the
+   instruction is in the source. */
+static inline int load_instruction (loading_t *loading, bf_op_t op, size_t at)
+{
+    if ((op.op == BF_ADD || op.op == BF_MOVE) && loading->length > 0){
+        bf_op_t *last = loading->ops + loading->length - 1;
+        if (last->op == op.op){
+            last->arg += op.arg;
+            if (last->arg == 0)
+                loading->length--;
+            return STATUS_OK;
+        }
+    }
+
+    // Room for this instruction and the final BF_END
+    if (loading->length + 2 > loading->max){
+        loading->max *= 2;
+        loading->ops = realloc(loading->ops, loading->max * sizeof(bf_op_t));
+        if (loading->sources != NULL)
+            loading->sources = realloc(loading->sources,
+                                       loading->max * sizeof(size_t));
+    }
+
+    size_t i = loading->length++;
+    if (loading->sources != NULL)
+        loading->sources[i] = at;
+    switch(op.op){
+    case BF_LOOP_START:
+        if (loading->depth == loading->max_depth){
+            loading->max_depth *= 2;
+            loading->open_loops = realloc(loading->open_loops,
+                                          loading->max_depth * sizeof(int));
+        }
+        loading->open_loops[loading->depth++] = i;
+        break;
+    case BF_LOOP_END: {
+        if (loading->depth == 0)
+            return STATUS_LOOP_END_BEFORE_START;
+        // The innermost open BF_LOOP_START is the one matching it
+        int loop_start = loading->open_loops[--loading->depth];
+        // Set pointer from start to end, and from end to start
+        loading->ops[loop_start].arg = i;
+        op.arg = loop_start;
+        break;
+    }
+    }
+    loading->ops[i] = op;
+    return STATUS_OK;
+}
+
+#if defined(__x86_64__)
+// Mask of the bytes of `text`, 16 of them, that are instructions
+static inline uint32_t source_instructions (const char *text)
+{
+    __m128i bytes = _mm_loadu_si128((const __m128i *) text);
+    // '+' ',' '-' '.' follow each other, the others are tested one by one
+    __m128i io = _mm_cmplt_epi8(_mm_sub_epi8(bytes, _mm_set1_epi8('+' + 128)),
+                                _mm_set1_epi8(-128 + 4));
+    __m128i found = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('<')),
+                     _mm_cmpeq_epi8(bytes, _mm_set1_epi8('>'))),
+        _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('[')),
+                     _mm_cmpeq_epi8(bytes, _mm_set1_epi8(']'))));
+    return _mm_movemask_epi8(_mm_or_si128(io, found));
+}
+#endif
+
+/* Sets the line and column of every instruction from its offset in the
+   source, going through the source once as the offsets only grow */
+void positions_from_sources (bf_position_t *positions, const size_t *sources,
+                             size_t length, const char *text)
+{
+    uint32_t line = 1;
+    size_t line_start = 0;
+    size_t at = 0;
+    for (size_t i = 0; i < length; i++){
+        for (; at < sources[i]; at++)
+            if (text[at] == '\n'){
+                line++;
+                line_start = at + 1;
+            }
+        positions[i] = (bf_position_t) {line, sources[i] - line_start + 1};
+    }
+}
+
+/* Builds instruction space straight from the source code, in a
+   single pass. Comments are skipped 16 bytes at a time where SSE2 is there
+   to find the instructions among them. Pages of a mapped source are given
+   back once they have been read, so they do not add up in memory.
+   If `bf_data->positions` is not NULL it gets the position of every
+   instruction. */
+int bf_data_from_source (bf_data_t *bf_data, source_t *source)
+{
+    loading_t loading = {malloc(64 * sizeof(bf_op_t)), 0, 64,
+                         bf_data->positions ? malloc(64 * sizeof(size_t)) : NULL,
+                         malloc(16 * sizeof(int)), 0, 16};
+    const char *text = source->text;
+    size_t length = source->length;
+    int status = STATUS_OK;
+    size_t i = 0;
+
+    for (size_t window = 0; window < length && status == STATUS_OK;
+         window += SOURCE_WINDOW_SIZE){
+        size_t until = length - window > SOURCE_WINDOW_SIZE
+                     ? window + SOURCE_WINDOW_SIZE : length;
+#if defined(__x86_64__)
+        for (; i + 16 <= until && status == STATUS_OK; i += 16){
+            uint32_t found = source_instructions(text + i);
+            while (found != 0 && status == STATUS_OK){
+                size_t at = i + __builtin_ctz(found);
+                unsigned char c = text[at];
+                status = load_instruction(&loading, bf_instructions[c], at);
+                found &= found - 1;
+            }
+        }
+#endif
+        for (; i < until && status == STATUS_OK; i++){
+            bf_op_t op = bf_instructions[(unsigned char) text[i]];
+            if (op.op != BF_END)
+                status = load_instruction(&loading, op, i);
+        }
+
+        if (source->mapping != NULL)
+            madvise((char *) source->mapping + window, until - window,
+                    MADV_DONTNEED);
+    }
+
+    // Error if BF_LOOP_START and BF_LOOP_END aren't balanced
+    if (status == STATUS_OK && loading.depth != 0)
+        status = STATUS_UNBALANCED_LOOP;
+
+    free(loading.open_loops);
+    if (status != STATUS_OK){
+        free(loading.ops);
+        free(loading.sources);
+        return status;
+    }
+
+    /* Positions are only needed for profiles, and those only cost the
+       extra pass over the source here */
+    if (loading.sources != NULL){
+        free(bf_data->positions);
+        bf_data->positions = malloc((loading.length + 1) * sizeof(bf_position_t));
+        positions_from_sources(bf_data->positions, loading.sources,
+                               loading.length, text);
+        bf_data->positions[loading.length] = (bf_position_t) {0, 0};
+        free(loading.sources);
+    }
+
+    // Give back what the doubling left unused
+    loading.ops[loading.length] = (bf_op_t) {BF_END, 0, 0, 0};
+    free(bf_data->ops);
+    bf_data->ops = realloc(loading.ops, (loading.length + 1) * sizeof(bf_op_t));
+    bf_data->length = loading.length;
+
+    return STATUS_OK;
+}
+
+// Number of bf_op_ts an instruction takes, with the BF_TERMs after it
+static inline int bf_op_length (const bf_op_t *op)
+{
+    return op->op == BF_MUL_ADD || op->op == BF_PUT_RUN || op->op == BF_WRITE
+        ? 1 + op->arg : 1;
+}
+
+/* `value` as the cells of `cell_size` bytes see it, as a signed number so
+   products with a cell never overflow an int */
+static inline int32_t peephole_wrap (uint32_t value, size_t cell_size)
+{
+    if (cell_size == 4)
+        return (int32_t) value;
+    int bits = 8 * cell_size;
+    value &= ((uint32_t) 1 << bits) - 1;
+    return value >> (bits - 1) ? (int32_t) value - ((int32_t) 1 << bits)
+                               : (int32_t) value;
+}
+
+/* How often a loop that changes its counter by the odd `change` goes
+   around, per unit of the counter: the loop ends once the counter times
+   that is a multiple of the cell size, -1 / `change` in its arithmetic.
+   Newton's iteration doubles the bits the inverse is right for each time. */
+static inline uint32_t peephole_iterations (uint32_t change)
+{
+    uint32_t inverse = change; // Right for 3 bits, as change * change is 1 mod 8
+    for (int i = 0; i < 4; i++)
+        inverse *= 2 - change * inverse;
+    return -inverse;
+}
+
+/* Tries to replace the loop starting at `start` in instruction space by a
+   single instruction, written to `out`, for cells of `cell_size` bytes.
+   Returns the number of bf_op_ts written, or 0 if the loop is not one of
+   the known idioms. */
+int peephole_loop (bf_op_t *ops, int start, bf_op_t *out, size_t cell_size)
+{
+    int end = ops[start].arg;
+    int i;
+
+    // Only innermost loops consisting of BF_ADD and BF_MOVE
+    for (i = start + 1; i < end; i++)
+        if (ops[i].op != BF_ADD && ops[i].op != BF_MOVE)
+            return 0;
+
+    // [-], [+], [>] and [<] (or longer runs of all of these)
+    if (end - start == 2){
+        bf_op_t body = ops[start + 1];
+        if (body.op == BF_MOVE){
+            out[0] = (bf_op_t) {BF_SCAN, 0, 0, body.arg};
+            return 1;
+        }
+        if (body.arg % 2 == 0)
+            return 0; // Never ends for some values
+        out[0] = (bf_op_t) {BF_CLEAR, 0, 0, 0};
+        return 1;
+    }
+
+    /* Otherwise it may be a multiply loop like [->+>++<<], which moves back
+       to where it started and changes that cell by an odd amount, so it
+       ends for every value (see `peephole_iterations`). Sum the changes per
+       offset into the BF_TERMs after a BF_MUL_ADD, times the iterations. */
+    int offset = 0;
+    int change = 0; // Change to the cell at offset 0
+    int count = 0;
+    for (i = start + 1; i < end; i++){
+        if (ops[i].op == BF_MOVE){
+            offset += ops[i].arg;
+            continue;
+        }
+
+        if (offset == 0){
+            change += ops[i].arg;
+            continue;
+        }
+        if (!BF_OFFSET_FITS(offset))
+            return 0;
+
+        int term = 1;
+        while (term <= count && out[term].offset != offset)
+            term++;
+        if (term > count){
+            out[term] = (bf_op_t) {BF_TERM, 0, offset, 0};
+            count++;
+        }
+        out[term].arg += ops[i].arg;
+    }
+
+    if (offset != 0 || change % 2 == 0)
+        return 0;
+
+    // Drop the terms whose changes cancelled out
+    uint32_t iterations = peephole_iterations(change);
+    int kept = 0;
+    for (i = 1; i <= count; i++){
+        out[i].arg = peephole_wrap(out[i].arg * iterations, cell_size);
+        if (out[i].arg != 0)
+            out[++kept] = out[i];
+    }
+
+    if (kept == 0){
+        out[0] = (bf_op_t) {BF_CLEAR, 0, 0, 0};
+        return 1;
+    }
+
+    out[0] = (bf_op_t) {BF_MUL_ADD, 0, 0, kept};
+    return 1 + kept;
+}
+
+/* Replaces clear, scan and multiply loops in instruction space as
+   described in `peephole_loop`, recomputing the loop destinations. The
+   instruction replacing a loop gets the position of its BF_LOOP_START. */
+void peephole (bf_data_t *bf_data)
+{
+    bf_op_t *ops = bf_data->ops;
+    bf_position_t *positions = bf_data->positions;
+
+    int loops = 0;
+    size_t i;
+    for (i = 0; i < bf_data->length; i++)
+        if (ops[i].op == BF_LOOP_START)
+            loops++;
+
+    // The result is never larger, and ends in a BF_END thanks to calloc
+    bf_op_t *optimized = calloc(bf_data->length + 1, sizeof(bf_op_t));
+    bf_position_t *new_positions = positions == NULL ? NULL
+        : calloc(bf_data->length + 1, sizeof(bf_position_t));
+
+    // Positions of the BF_LOOP_STARTs in `optimized` still waiting for an end
+    int *loop_starts = calloc(loops + 1, sizeof(int));
+    int depth = 0;
+
+    size_t i_old = 0;
+    size_t i_new = 0;
+    while (ops[i_old].op != BF_END) {
+        int length = bf_op_length(ops + i_old);
+        int written;
+
+        if (positions != NULL)
+            for (int j = 0; j < length; j++)
+                new_positions[i_new + j] = positions[i_old + j];
+
+        switch(ops[i_old].op){
+        case BF_LOOP_START:
+            written = peephole_loop(ops, i_old, optimized + i_new,
+                                    bf_data->cell_size);
+            if (written != 0){
+                if (positions != NULL)
+                    for (int j = 1; j < written; j++)
+                        new_positions[i_new + j] = positions[i_old];
+                i_new += written;
+                i_old = ops[i_old].arg + 1; // Skip past end of loop
+                continue;
+            }
+            loop_starts[depth++] = i_new;
+            optimized[i_new] = ops[i_old];
+            break;
+        case BF_LOOP_END: {
+            int loop_start = loop_starts[--depth];
+            optimized[loop_start].arg = i_new;
+            optimized[i_new] = (bf_op_t) {BF_LOOP_END, 0, 0, loop_start};
+            break;
+        }
+        default:
+            memcpy(optimized + i_new, ops + i_old, length * sizeof(bf_op_t));
+        }
+        i_old += length;
+        i_new += length;
+    }
+
+    free(loop_starts);
+
+    // Replace instruction space by optimized instruction space
+    free(ops);
+    free(positions);
+    bf_data->ops = optimized;
+    bf_data->positions = new_positions;
+    bf_data->length = i_new;
+}
+
+/* What `constants` knows about a cell of the tape */
+enum {
+    CONSTANT_CLEAN,   // Holds its value, and so does the tape
+    CONSTANT_DIRTY,   // Holds its value, but the tape does not have it yet
+    CONSTANT_UNKNOWN, // Depends on the input
 };
 
-// Instructions
-enum {
-    BF_UNDEFINED = 0, // in `instructions`, not initialized is undefined
-    BF_INC,        BF_DEC,
-    BF_GET,        BF_PUT,
-    BF_NEXT,       BF_PREV,
-    BF_LOOP_START = -1, BF_LOOP_END = -2,
-};
+// Steps `constants` takes running loops while compiling, unless told otherwise
+#define CONSTANTS_STEP_MAX ((long) 1 << 20)
+
+// Cells `constants` keeps track of, it gives up past them
+#define CONSTANTS_CELLS_MAX ((size_t) 1 << 16)
+
+// Bytes a BF_WRITE holds at most
+#define CONSTANTS_WRITE_MAX 256
+
+// State of `constants`, the tape as far as it is known and what it wrote
+typedef struct {
+    uint32_t *values;
+    unsigned char *states;
+    unsigned char *written; // Whether written code works on the cell
+    size_t cells;  // Cells used, the others are still 0 and clean
+    uint32_t mask; // Of the bits in a cell
+    long long pos; // Memory pointer
+    long steps;
+    long steps_max;
+    // Output that is known, but not written yet
+    unsigned char *output;
+    size_t output_length;
+    size_t output_max;
+    // Instruction space being written, and where its memory pointer is
+    bf_op_t *ops;
+    bf_position_t *positions;
+    size_t length;
+    size_t max;
+    long long emitted_pos;
+    bf_position_t position; // Of the instruction being worked on
+} constants_t;
+
+// Notes that cell `at` is used and returns it
+static inline size_t constants_cell (constants_t *c, size_t at)
+{
+    if (at >= c->cells)
+        c->cells = at + 1;
+    return at;
+}
+
+static inline void constants_set (constants_t *c, size_t at, uint32_t value)
+{
+    constants_cell(c, at);
+    c->values[at] = value & c->mask;
+    c->states[at] = CONSTANT_DIRTY;
+}
+
+void constants_output (constants_t *c, uint32_t value)
+{
+    if (c->output_length == c->output_max){
+        c->output_max = c->output_max ? c->output_max * 2 : 256;
+        c->output = realloc(c->output, c->output_max);
+    }
+    c->output[c->output_length++] = value;
+}
+
+void constants_emit (constants_t *c, int op, int offset, int arg)
+{
+    if (c->length + 2 > c->max){
+        c->max *= 2;
+        c->ops = realloc(c->ops, c->max * sizeof(bf_op_t));
+        if (c->positions != NULL)
+            c->positions = realloc(c->positions, c->max * sizeof(bf_position_t));
+    }
+    if (c->positions != NULL)
+        c->positions[c->length] = c->position;
+    c->ops[c->length++] = (bf_op_t) {op, 0, offset, arg};
+}
+
+// Writes `op` for the cell `at`, moving the memory pointer there first
+void constants_emit_at (constants_t *c, long long at, int op, int arg)
+{
+    if (at != c->emitted_pos)
+        constants_emit(c, BF_MOVE, 0, at - c->emitted_pos);
+    c->emitted_pos = at;
+    c->written[at] = 1;
+    constants_emit(c, op, 0, arg);
+}
+
+// Writes the output known so far as BF_WRITEs
+void constants_flush_output (constants_t *c)
+{
+    for (size_t done = 0; done < c->output_length; done += CONSTANTS_WRITE_MAX){
+        size_t n = c->output_length - done;
+        if (n > CONSTANTS_WRITE_MAX)
+            n = CONSTANTS_WRITE_MAX;
+        constants_emit(c, BF_WRITE, 0, n);
+        for (size_t i = 0; i < n; i++)
+            constants_emit(c, BF_TERM, 0, c->output[done + i]);
+    }
+    c->output_length = 0;
+}
+
+// Writes the value of cell `at` to the tape, if it is not there yet
+void constants_store (constants_t *c, size_t at)
+{
+    if (at < c->cells && c->states[at] == CONSTANT_DIRTY){
+        // Cells no written code worked on are still 0 on the tape
+        if (c->written[at] || c->values[at] != 0)
+            constants_emit_at(c, at, BF_SET, c->values[at]);
+        c->states[at] = CONSTANT_CLEAN;
+    }
+}
+
+/* Runs the instructions from `start` up to and including `end` on the
+   known tape, giving up (returning 0) on anything that is not known or
+   when there are no steps left */
+int constants_run (constants_t *c, const bf_op_t *ops, size_t start, size_t end)
+{
+    uint32_t *values = c->values;
+    unsigned char *states = c->states;
+    const uint32_t mask = c->mask;
+    long long pos = c->pos;
+    long steps = c->steps;
+    int ran = 0;
+
+    size_t i = start;
+    while (i <= end){
+        if (++steps > c->steps_max)
+            goto stop;
+        const bf_op_t *op = ops + i;
+        if (states[pos] == CONSTANT_UNKNOWN
+            && op->op != BF_MOVE && op->op != BF_CLEAR)
+            goto stop;
+        uint32_t value = values[pos];
+
+        switch (op->op){
+        case BF_ADD:
+            values[pos] = (value + op->arg) & mask;
+            states[pos] = CONSTANT_DIRTY;
+            break;
+        case BF_MOVE:
+            pos += op->arg;
+            if (pos < 0 || pos >= (long long) CONSTANTS_CELLS_MAX)
+                goto stop;
+            constants_cell(c, pos);
+            break;
+        case BF_PUT:
+            constants_output(c, value);
+            break;
+        case BF_CLEAR:
+            values[pos] = 0;
+            states[pos] = CONSTANT_DIRTY;
+            break;
+        case BF_SCAN:
+            while (values[pos] != 0){
+                pos += op->arg;
+                if (pos < 0 || pos >= (long long) CONSTANTS_CELLS_MAX
+                    || ++steps > c->steps_max || states[pos] == CONSTANT_UNKNOWN)
+                    goto stop;
+                constants_cell(c, pos);
+            }
+            break;
+        case BF_MUL_ADD:
+            if (value != 0){
+                for (int term = 1; term <= op->arg; term++){
+                    long long to = pos + op[term].offset;
+                    if (to < 0 || to >= (long long) CONSTANTS_CELLS_MAX
+                        || states[to] == CONSTANT_UNKNOWN)
+                        goto stop;
+                    constants_cell(c, to);
+                    values[to] = (values[to] + value * op[term].arg) & mask;
+                    states[to] = CONSTANT_DIRTY;
+                }
+                values[pos] = 0;
+                states[pos] = CONSTANT_DIRTY;
+            }
+            break;
+        case BF_LOOP_START:
+            if (value == 0){
+                i = op->arg + 1;
+                continue;
+            }
+            break;
+        case BF_LOOP_END:
+            if (value != 0){
+                i = op->arg + 1;
+                continue;
+            }
+            break;
+        default:
+            // BF_GET, which is not known
+            goto stop;
+        }
+        i += bf_op_length(op);
+    }
+    ran = 1;
+
+stop:
+    c->pos = pos;
+    c->steps = steps;
+    return ran;
+}
+
+/* Works out what the start of the program does from the tape being all
+   zeros, as long as it does not depend on the input and the memory pointer
+   stays known. Cells that get values are only written to the tape (by a
+   BF_SET) when something needs them there, and output of known cells is
+   written as it is (by a BF_WRITE). Loops that are known not to run are
+   dropped, and loops that are known to run are run right here, if that
+   takes at most `steps_max` steps in all. If the whole program can be run
+   like that, which needs it not to read input, all that is left of it is
+   the BF_WRITEs of its output. From the first thing that cannot be known
+   on, the program stays as it was, except that loops (and clears, scans
+   and multiplies) right after the end of a loop, where the cell is always
+   0, are dropped as well. */
+void constants (bf_data_t *bf_data, long steps_max)
+{
+    const bf_op_t *ops = bf_data->ops;
+    constants_t c = {
+        .values = calloc(CONSTANTS_CELLS_MAX, sizeof(uint32_t)),
+        .states = calloc(CONSTANTS_CELLS_MAX, 1),
+        .written = calloc(CONSTANTS_CELLS_MAX, 1),
+        .cells = 1,
+        .mask = bf_data->cell_size == 4 ? UINT32_MAX
+              : ((uint32_t) 1 << (8 * bf_data->cell_size)) - 1,
+        .ops = malloc(64 * sizeof(bf_op_t)),
+        .positions = bf_data->positions ? malloc(64 * sizeof(bf_position_t)) : NULL,
+        .max = 64,
+        .steps_max = steps_max,
+    };
+
+    size_t i = 0;
+    while (ops[i].op != BF_END){
+        const bf_op_t *op = ops + i;
+        if (c.positions != NULL)
+            c.position = bf_data->positions[i];
+        size_t at = constants_cell(&c, c.pos);
+        int known = c.states[at] != CONSTANT_UNKNOWN;
+        uint32_t value = c.values[at];
+
+        if (op->op == BF_MOVE){
+            if (c.pos + op->arg < 0 || c.pos + op->arg >= (long long) CONSTANTS_CELLS_MAX)
+                break;
+            c.pos += op->arg;
+        } else if (op->op == BF_ADD && known){
+            constants_set(&c, at, value + op->arg);
+        } else if (op->op == BF_ADD){
+            constants_emit_at(&c, at, BF_ADD, op->arg);
+        } else if (op->op == BF_PUT && known){
+            constants_output(&c, value);
+        } else if (op->op == BF_PUT || op->op == BF_GET){
+            constants_flush_output(&c);
+            // The end of input can leave the cell as it was
+            if (op->op == BF_GET && bf_data->eof == EOF_UNCHANGED)
+                constants_store(&c, at);
+            constants_emit_at(&c, at, op->op, 0);
+            if (op->op == BF_GET)
+                c.states[at] = CONSTANT_UNKNOWN;
+        } else if (op->op == BF_CLEAR){
+            constants_set(&c, at, 0);
+        } else if (known && value == 0
+                   && (op->op == BF_SCAN || op->op == BF_MUL_ADD
+                       || op->op == BF_LOOP_START)){
+            // Does nothing, or is a loop that does not run
+            if (op->op == BF_LOOP_START){
+                i = op->arg + 1;
+                continue;
+            }
+        } else if (op->op == BF_MUL_ADD){
+            int term;
+            for (term = 1; term <= op->arg; term++){
+                long long to = c.pos + op[term].offset;
+                if (to < 0 || to >= (long long) CONSTANTS_CELLS_MAX)
+                    break;
+            }
+            if (term <= op->arg)
+                break;
+
+            if (known){
+                // Add a known amount, to a known cell or on the tape
+                for (term = 1; term <= op->arg; term++){
+                    size_t to = constants_cell(&c, c.pos + op[term].offset);
+                    uint32_t amount = value * op[term].arg;
+                    if (c.states[to] != CONSTANT_UNKNOWN)
+                        constants_set(&c, to, c.values[to] + amount);
+                    else if ((amount & c.mask) != 0)
+                        constants_emit_at(&c, to, BF_ADD, amount);
+                }
+                constants_set(&c, at, 0);
+            } else {
+                // The tape must have what is added to, which is unknown after
+                for (term = 1; term <= op->arg; term++)
+                    constants_store(&c, constants_cell(&c, c.pos + op[term].offset));
+                constants_emit_at(&c, at, BF_MUL_ADD, op->arg);
+                for (term = 1; term <= op->arg; term++){
+                    constants_emit(&c, BF_TERM, op[term].offset, op[term].arg);
+                    c.states[c.pos + op[term].offset] = CONSTANT_UNKNOWN;
+                    c.written[c.pos + op[term].offset] = 1;
+                }
+                c.states[at] = CONSTANT_CLEAN;
+                c.values[at] = 0;
+            }
+        } else if ((op->op == BF_LOOP_START || op->op == BF_SCAN) && known){
+            // Run the loop, or go on with the program as it is from here
+            size_t end = op->op == BF_LOOP_START ? (size_t) op->arg : i;
+            size_t cells = c.cells;
+            long long pos = c.pos;
+            size_t output_length = c.output_length;
+            uint32_t *values = malloc(cells * sizeof(uint32_t));
+            unsigned char *states = malloc(cells);
+            memcpy(values, c.values, cells * sizeof(uint32_t));
+            memcpy(states, c.states, cells);
+            int ran = constants_run(&c, ops, i, end);
+            if (!ran){
+                memcpy(c.values, values, cells * sizeof(uint32_t));
+                memcpy(c.states, states, cells);
+                memset(c.values + cells, 0, (c.cells - cells) * sizeof(uint32_t));
+                memset(c.states + cells, CONSTANT_CLEAN, c.cells - cells);
+                c.cells = cells;
+                c.pos = pos;
+                c.output_length = output_length;
+            }
+            free(values);
+            free(states);
+            if (!ran)
+                break;
+            i = end + 1;
+            continue;
+        } else
+            break;
+        i += bf_op_length(op);
+    }
+
+    // Everything from here is kept, so the tape must be as the program left it
+    constants_flush_output(&c);
+    if (ops[i].op != BF_END){
+        for (size_t at = 0; at < c.cells; at++)
+            constants_store(&c, at);
+        if (c.pos != c.emitted_pos)
+            constants_emit(&c, BF_MOVE, 0, c.pos - c.emitted_pos);
+    }
+
+    size_t *renumbered = malloc((bf_data->length + 1) * sizeof(size_t));
+    size_t kept_from = c.length;
+    int zero = 0; // Whether the cell is 0 for sure, as after a loop
+    while (ops[i].op != BF_END){
+        const bf_op_t *op = ops + i;
+        int length = bf_op_length(op);
+        switch (op->op){
+        case BF_LOOP_START:
+        case BF_CLEAR:
+        case BF_SCAN:
+        case BF_MUL_ADD:
+            if (zero){
+                i = op->op == BF_LOOP_START ? (size_t) op->arg + 1 : i + length;
+                continue;
+            }
+        }
+        zero = op->op == BF_LOOP_END || op->op == BF_CLEAR
+            || op->op == BF_SCAN || op->op == BF_MUL_ADD;
+
+        renumbered[i] = c.length;
+        for (int j = 0; j < length; j++){
+            if (c.positions != NULL)
+                c.position = bf_data->positions[i + j];
+            constants_emit(&c, op[j].op, op[j].offset, op[j].arg);
+        }
+        i += length;
+    }
+    for (size_t j = kept_from; j < c.length; j++)
+        if (c.ops[j].op == BF_LOOP_START || c.ops[j].op == BF_LOOP_END)
+            c.ops[j].arg = renumbered[c.ops[j].arg];
+    c.ops[c.length] = (bf_op_t) {BF_END, 0, 0, 0};
+    if (c.positions != NULL)
+        c.positions[c.length] = (bf_position_t) {0, 0};
+
+    free(renumbered);
+    free(c.values);
+    free(c.states);
+    free(c.written);
+    free(c.output);
+    free(bf_data->ops);
+    free(bf_data->positions);
+    bf_data->ops = c.ops;
+    bf_data->positions = c.positions;
+    bf_data->length = c.length;
+}
+
+// Maximum number of distinct offsets `lower` keeps additions pending for
+#define LOWER_PENDING_MAX 64
+
+// Maximum number of cells a BF_PUT_RUN writes
+#define LOWER_PUT_RUN_MAX 256
+
+// State of `lower` while it works through a basic block
+typedef struct {
+    bf_op_t *lowered;
+    size_t i_new;
+    // Positions of the lowered instructions if kept, and of the current one
+    bf_position_t *positions;
+    bf_position_t position;
+    // Additions not yet written out, per offset
+    int pending;
+    int offsets[LOWER_PENDING_MAX];
+    int amounts[LOWER_PENDING_MAX];
+    // Index of the last BF_PUT or BF_PUT_RUN written, -1 if none
+    long put;
+} lowering_t;
+
+void lower_emit (lowering_t *lowering, int op, int offset, int arg)
+{
+    if (lowering->positions != NULL)
+        lowering->positions[lowering->i_new] = lowering->position;
+    lowering->lowered[lowering->i_new++] = (bf_op_t) {op, 0, offset, arg};
+}
+
+// Writes out the pending addition at index `p` and forgets about it
+void lower_flush_pending (lowering_t *lowering, int p)
+{
+    if (lowering->amounts[p] != 0)
+        lower_emit(lowering, BF_ADD, lowering->offsets[p], lowering->amounts[p]);
+    lowering->pending--;
+    lowering->offsets[p] = lowering->offsets[lowering->pending];
+    lowering->amounts[p] = lowering->amounts[lowering->pending];
+}
+
+// Index of the pending addition to `offset`, or -1 if there is none
+int lower_find_pending (lowering_t *lowering, int offset)
+{
+    for (int p = 0; p < lowering->pending; p++)
+        if (lowering->offsets[p] == offset)
+            return p;
+    return -1;
+}
+
+void lower_flush_all (lowering_t *lowering)
+{
+    while (lowering->pending > 0)
+        lower_flush_pending(lowering, 0);
+}
+
+/* Ends the basic block, writing out the pending additions and moving the
+   memory pointer by the `offset` it moved since the start of the block */
+void lower_end_block (lowering_t *lowering, int *offset)
+{
+    lower_flush_all(lowering);
+    if (*offset != 0){
+        lower_emit(lowering, BF_MOVE, 0, *offset);
+        *offset = 0;
+    }
+}
+
+// Whether every cell `op` works on is within an OFFSET from `offset`
+int lower_fits (const bf_op_t *op, int offset)
+{
+    if (!BF_OFFSET_FITS(offset + op->offset))
+        return 0;
+    if (op->op == BF_MUL_ADD)
+        for (int term = 1; term <= op->arg; term++)
+            if (!BF_OFFSET_FITS(offset + op[term].offset))
+                return 0;
+    return 1;
+}
+
+/* Writes out the output of the cell at `offset`, joining the BF_PUT or
+   BF_PUT_RUN written last into a BF_PUT_RUN when nothing came after it */
+void lower_put (lowering_t *lowering, int offset)
+{
+    bf_op_t *lowered = lowering->lowered;
+    long put = lowering->put;
+    if (put != -1 && put + bf_op_length(lowered + put) == (long) lowering->i_new){
+        if (lowered[put].op == BF_PUT){
+            lowered[put + 1] = (bf_op_t) {BF_TERM, 0, lowered[put].offset, 0};
+            lowered[put] = (bf_op_t) {BF_PUT_RUN, 0, 0, 1};
+            if (lowering->positions != NULL)
+                lowering->positions[put + 1] = lowering->positions[put];
+            lowering->i_new++;
+        }
+        if (lowered[put].arg < LOWER_PUT_RUN_MAX){
+            lowered[put].arg++;
+            lower_emit(lowering, BF_TERM, offset, 0);
+            return;
+        }
+    }
+    lowering->put = lowering->i_new;
+    lower_emit(lowering, BF_PUT, offset, 0);
+}
+
+/* Folds pointer movement into the instructions that use it. Within a
+   basic block (the instructions between loop constructs and scans) every
+   instruction gets the OFFSET from the memory pointer it works on,
+   additions to the same cell are merged, and the pointer itself is only
+   moved once, by a BF_MOVE at the end of the block. A block is also ended
+   early where an OFFSET would no longer fit. BF_PUTs with nothing in
+   between are joined into a BF_PUT_RUN. Instructions get the position of
+   the one that caused them to be written. */
+void lower (bf_data_t *bf_data)
+{
+    bf_op_t *ops = bf_data->ops;
+
+    int loops = 0;
+    size_t i;
+    for (i = 0; i < bf_data->length; i++)
+        if (ops[i].op == BF_LOOP_START)
+            loops++;
+
+    // Every instruction becomes at most two, so twice the size will do
+    lowering_t lowering = {calloc(2 * bf_data->length + 1, sizeof(bf_op_t)), 0};
+    if (bf_data->positions != NULL)
+        lowering.positions = calloc(2 * bf_data->length + 1, sizeof(bf_position_t));
+    lowering.put = -1;
+    bf_op_t *lowered = lowering.lowered;
+
+    int *loop_starts = calloc(loops + 1, sizeof(int));
+    int depth = 0;
+
+    // Pointer movement since the start of the basic block
+    int offset = 0;
+
+    size_t i_old = 0;
+    int p;
+    for (;;) {
+        bf_op_t *op = ops + i_old;
+        int length = bf_op_length(op);
+        int at = offset + op->offset;
+        if (bf_data->positions != NULL)
+            lowering.position = bf_data->positions[i_old];
+
+        switch(op->op){
+        case BF_ADD:
+        case BF_GET:
+        case BF_PUT:
+        case BF_CLEAR:
+        case BF_SET:
+        case BF_MUL_ADD:
+            if (!lower_fits(op, offset)){
+                lower_end_block(&lowering, &offset);
+                at = op->offset;
+            }
+        }
+
+        switch(op->op){
+        case BF_ADD:
+            p = lower_find_pending(&lowering, at);
+            if (p == -1){
+                if (lowering.pending == LOWER_PENDING_MAX)
+                    lower_flush_all(&lowering);
+                p = lowering.pending++;
+                lowering.offsets[p] = at;
+                lowering.amounts[p] = 0;
+            }
+            lowering.amounts[p] += op->arg;
+            break;
+        case BF_MOVE:
+            offset += op->arg;
+            break;
+        case BF_PUT:
+            // Only the cell being written needs its additions done
+            if ((p = lower_find_pending(&lowering, at)) != -1)
+                lower_flush_pending(&lowering, p);
+            lower_put(&lowering, at);
+            break;
+        case BF_GET:
+        case BF_CLEAR:
+        case BF_SET:
+            // Additions to a cell that gets overwritten can be dropped,
+            // unless the end of input leaves it as it was
+            if ((p = lower_find_pending(&lowering, at)) != -1){
+                if (op->op != BF_GET || bf_data->eof != EOF_UNCHANGED)
+                    lowering.amounts[p] = 0;
+                lower_flush_pending(&lowering, p);
+            }
+            lower_emit(&lowering, op->op, at, op->arg);
+            break;
+        case BF_WRITE:
+            // Works on no cell, so it does not end the block
+            for (int j = 0; j < length; j++)
+                lower_emit(&lowering, op[j].op, 0, op[j].arg);
+            break;
+        case BF_MUL_ADD:
+            lower_flush_all(&lowering);
+            lower_emit(&lowering, BF_MUL_ADD, at, op->arg);
+            for (int term = 1; term <= op->arg; term++)
+                lower_emit(&lowering, BF_TERM, offset + op[term].offset,
+                           op[term].arg);
+            break;
+        default:
+            // End of the basic block, the memory pointer has to be right
+            lower_end_block(&lowering, &offset);
+
+            switch(op->op){
+            case BF_END:
+                lowered[lowering.i_new] = *op;
+                free(loop_starts);
+                free(ops);
+                free(bf_data->positions);
+                bf_data->ops = lowered;
+                bf_data->positions = lowering.positions;
+                bf_data->length = lowering.i_new;
+                return;
+            case BF_LOOP_START:
+                loop_starts[depth++] = lowering.i_new;
+                lower_emit(&lowering, BF_LOOP_START, 0, 0);
+                break;
+            case BF_LOOP_END: {
+                int loop_start = loop_starts[--depth];
+                lowered[loop_start].arg = lowering.i_new;
+                lower_emit(&lowering, BF_LOOP_END, 0, loop_start);
+                break;
+            }
+            default:
+                memcpy(lowered + lowering.i_new, op, length * sizeof(bf_op_t));
+                if (lowering.positions != NULL)
+                    for (int j = 0; j < length; j++)
+                        lowering.positions[lowering.i_new + j] = lowering.position;
+                lowering.i_new += length;
+            }
+        }
+        i_old += length;
+    }
+}
+
+/* Returns how far past the memory pointer the lowered basic block starting
+   at `start` reaches, sets `lowest` to how far before it the block always
+   goes (0 at most), and `end` to the first instruction after it. A BF_MOVE
+   is the last instruction of a block. The terms of a BF_MUL_ADD are left
+   out of `lowest`, as they are only touched when its counter is not 0. */
+int block_reach (const bf_op_t *ops, int start, int *end, int *lowest)
+{
+    int reach = 0;
+    int i = start;
+    *lowest = 0;
+    for (;;) {
+        int furthest = ops[i].offset;
+        int nearest = ops[i].offset;
+        switch(ops[i].op){
+        case BF_ADD:
+        case BF_GET:
+        case BF_PUT:
+        case BF_CLEAR:
+        case BF_SET:
+        case BF_WRITE:
+            break;
+        case BF_MUL_ADD:
+        case BF_PUT_RUN:
+            for (int term = 1; term <= ops[i].arg; term++){
+                if (ops[i + term].offset > furthest)
+                    furthest = ops[i + term].offset;
+                if (ops[i].op == BF_PUT_RUN && ops[i + term].offset < nearest)
+                    nearest = ops[i + term].offset;
+            }
+            break;
+        case BF_MOVE:
+            *end = i + 1;
+            if (ops[i].arg < *lowest)
+                *lowest = ops[i].arg;
+            return ops[i].arg > reach ? ops[i].arg : reach;
+        default:
+            // Anything else is not part of a block, but must be stepped over
+            if (i == start)
+                i += bf_op_length(ops + i);
+            *end = i;
+            return reach;
+        }
+        if (furthest > reach)
+            reach = furthest;
+        if (nearest < *lowest)
+            *lowest = nearest;
+        i += bf_op_length(ops + i);
+    }
+}
+
+/* Cells instructions work on, relative to where the memory pointer was at
+   the start of a loop (or the program), while `known` says the pointer
+   never moved by an amount that depends on the tape */
+typedef struct {
+    long long moved;
+    long long lo;
+    long long hi;
+    int known;
+} bounds_t;
+
+// Largest tape `bounds` sizes up front, in bytes
+#define BOUNDS_TAPE_MAX ((size_t) 1 << 30)
+
+static inline void bounds_touch (bounds_t *range, long long cell)
+{
+    if (cell < range->lo)
+        range->lo = cell;
+    if (cell > range->hi)
+        range->hi = cell;
+}
+
+// Whether the loop with `range` returns to where it started every time
+static inline int bounds_balanced (const bounds_t *range)
+{
+    return range->known && range->moved == 0;
+}
+
+/* Proves which cells parts of the lowered program work on, so the checks
+   that the tape reaches them can go. A loop that returns to where it
+   started (a balanced one) with nothing like a scan in it works on the
+   same cells every time around. If the memory pointer is known to be far
+   enough from the start of the tape when it is entered, a BF_FIT before
+   it grows the tape for the whole loop at once, and all instructions of
+   the loop are marked BF_FLAG_BOUNDED. When the whole program is like
+   that, all of it is marked, and `tape_cells` is set to the size of the
+   tape it needs. */
+void bounds (bf_data_t *bf_data)
+{
+    bf_op_t *ops = bf_data->ops;
+    size_t length = bf_data->length;
+
+    // Ranges of every loop by its BF_LOOP_START, found by going through once
+    bounds_t *ranges = malloc((length + 1) * sizeof(bounds_t));
+    size_t *open = malloc((length + 1) * sizeof(size_t));
+    bounds_t *frames = malloc((length + 2) * sizeof(bounds_t));
+    size_t depth = 0;
+    frames[0] = (bounds_t) {0, 0, 0, 1};
+
+    size_t loops = 0;
+    for (size_t i = 0; i < length; i += bf_op_length(ops + i)){
+        bounds_t *frame = frames + depth;
+        switch (ops[i].op){
+        case BF_MOVE:
+            frame->moved += ops[i].arg;
+            break;
+        case BF_SCAN:
+            frame->known = 0;
+            break;
+        case BF_WRITE:
+            break;
+        case BF_LOOP_START:
+            bounds_touch(frame, frame->moved);
+            open[depth] = i;
+            frames[++depth] = (bounds_t) {0, 0, 0, 1};
+            loops++;
+            break;
+        case BF_LOOP_END: {
+            bounds_touch(frame, frame->moved);
+            bounds_t *outer = frame - 1;
+            ranges[open[--depth]] = *frame;
+            if (bounds_balanced(frame)){
+                bounds_touch(outer, outer->moved + frame->lo);
+                bounds_touch(outer, outer->moved + frame->hi);
+            } else
+                outer->known = 0;
+            break;
+        }
+        case BF_MUL_ADD:
+        case BF_PUT_RUN:
+            for (int term = 1; term <= ops[i].arg; term++)
+                bounds_touch(frame, frame->moved + ops[i + term].offset);
+            if (ops[i].op == BF_PUT_RUN)
+                break;
+            // Fall through, a BF_MUL_ADD works on its own cell as well
+        default:
+            bounds_touch(frame, frame->moved + ops[i].offset);
+        }
+    }
+    free(open);
+
+    // The whole program, which starts at the start of the tape
+    bounds_t program = frames[0];
+    free(frames);
+    if (program.known && program.lo >= 0
+        && (size_t) program.hi < BOUNDS_TAPE_MAX / bf_data->cell_size){
+        for (size_t i = 0; i < length; i++)
+            ops[i].flags |= BF_FLAG_BOUNDED;
+        bf_data->tape_cells = program.hi + 1;
+        free(ranges);
+        return;
+    }
+
+    /* Otherwise go through again, keeping the lowest the memory pointer can
+       be at, placing the BF_FITs and renumbering the loops around them */
+    bf_op_t *fitted = calloc(length + loops + 1, sizeof(bf_op_t));
+    bf_position_t *positions = bf_data->positions == NULL ? NULL
+        : calloc(length + loops + 1, sizeof(bf_position_t));
+    size_t *renumbered = malloc((length + 1) * sizeof(size_t));
+    long long *lowest_at_start = malloc((loops + 1) * sizeof(long long));
+    depth = 0;
+
+    long long lowest = 0;
+    size_t bounded_until = 0;
+    size_t i_new = 0;
+    for (size_t i = 0; i < length; i++){
+        bf_op_t op = ops[i];
+        if (op.op == BF_LOOP_START && i >= bounded_until){
+            const bounds_t *range = ranges + i;
+            if (bounds_balanced(range) && lowest + range->lo >= 0
+                && range->hi <= INT32_MAX){
+                if (positions != NULL)
+                    positions[i_new] = bf_data->positions[i];
+                fitted[i_new++] = (bf_op_t) {BF_FIT, 0, 0, range->hi};
+                bounded_until = op.arg + 1;
+            } else {
+                lowest_at_start[depth++] = lowest;
+                // Only loops that never go back bring the pointer no lower
+                if (!range->known || range->moved < 0)
+                    lowest = 0;
+            }
+        } else if (i >= bounded_until){
+            switch (op.op){
+            case BF_MOVE:
+                lowest += op.arg;
+                if (lowest < 0) // The program stops before going below 0
+                    lowest = 0;
+                break;
+            case BF_SCAN:
+                if (op.arg < 0)
+                    lowest = 0;
+                break;
+            case BF_LOOP_END: {
+                const bounds_t *range = ranges + op.arg;
+                lowest = lowest_at_start[--depth];
+                if (!range->known || range->moved < 0)
+                    lowest = 0;
+                break;
+            }
+            }
+        }
+
+        if (i < bounded_until)
+            op.flags |= BF_FLAG_BOUNDED;
+        if (positions != NULL)
+            positions[i_new] = bf_data->positions[i];
+        renumbered[i] = i_new;
+        fitted[i_new++] = op;
+    }
+    for (size_t i = 0; i < i_new; i++)
+        if (fitted[i].op == BF_LOOP_START || fitted[i].op == BF_LOOP_END)
+            fitted[i].arg = renumbered[fitted[i].arg];
+
+    free(lowest_at_start);
+    free(renumbered);
+    free(ranges);
+    free(ops);
+    free(bf_data->positions);
+    bf_data->ops = fitted;
+    bf_data->positions = positions;
+    bf_data->length = i_new;
+}
+
+// Runs the passes above on instruction space as loaded, in order
+void bf_data_optimize (bf_data_t *bf_data, long steps_max)
+{
+    // Replace common loop idioms by single instructions
+    peephole(bf_data);
+
+    // Work out the start of the program, which does not depend on the input
+    constants(bf_data, steps_max);
+
+    // Fold pointer movement into the instructions of each basic block
+    lower(bf_data);
+
+    // Grow the tape once for the loops known to stay within some cells
+    bounds(bf_data);
+}
+
+// Size of the buffer output is gathered in before it gets written
+#define OUTPUT_BUFFER_SIZE ((size_t) 1 << 16)
+
+/* Reads up to `size` bytes of input from `source` into `into`. Returns how
+   many it read, 0 at the end of input, or -1 if there is none yet. */
+typedef long input_read_t (void *source, void *into, size_t size);
+
+/* Output of the program, gathered in a buffer of its own and written to
+   `fd` in as few write(2) calls as possible instead of through stdio.
+   When `line_buffered`, as for a terminal, every line is written out as
+   soon as it ends, and before reading input. Opened by
+   `output_open_memory`, output goes to `into` instead. Output to `fd` is
+   written to `copy_fd` as well, unless that is -1.
+
+   Input comes from the bytes at `from`, and once those are used up from
+   `read`, in blocks in `in_data`, unless that is NULL. Without one that
+   can say there is none yet, reading input blocks. */
+typedef struct {
+    int fd;
+    int copy_fd;
+    int line_buffered;
+    unsigned char *into;
+    size_t into_size;
+    size_t into_used; // Past `into_size` when output did not fit
+    const unsigned char *from;
+    size_t from_length;
+    size_t from_used;
+    input_read_t *read;
+    void *source;
+    size_t used;
+    unsigned char data[OUTPUT_BUFFER_SIZE];
+    unsigned char in_data[OUTPUT_BUFFER_SIZE];
+} output_t;
+
+// The output in use by the current thread, written out on fatal errors
+static __thread output_t *active_output;
+
+/* Where the current thread goes when its program cannot go on, if set,
+   instead of exiting: when it leaves the tape, or its output is written
+   to memory that is full. A guarded tape is unmapped by then, other
+   memory of the run is lost. */
+static __thread sigjmp_buf *active_escape;
+
+// Writes `size` bytes to `fd`, only using write(2) so signal handlers can too
+void output_write (int fd, const unsigned char *data, size_t size)
+{
+    size_t done = 0;
+    while (done < size){
+        ssize_t written = write(fd, data + done, size - done);
+        if (written == -1 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            break; // Like with putchar, output that cannot go anywhere is lost
+        done += written;
+    }
+}
+
+// Writes out the buffer
+void output_flush (output_t *output)
+{
+    if (output->into != NULL){
+        size_t room = output->into_used < output->into_size
+            ? output->into_size - output->into_used : 0;
+        if (room > 0)
+            memcpy(output->into + output->into_used, output->data,
+                   output->used < room ? output->used : room);
+        output->into_used += output->used;
+        output->used = 0;
+        // Nothing more fits, so there is no use going on
+        if (output->into_used > output->into_size && active_escape != NULL)
+            siglongjmp(*active_escape, 1);
+        return;
+    }
+
+    output_write(output->fd, output->data, output->used);
+    if (output->copy_fd != -1)
+        output_write(output->copy_fd, output->data, output->used);
+    output->used = 0;
+}
+
+// Reads input from the file descriptor `source`, taking errors for its end
+long input_read_fd (void *source, void *into, size_t size)
+{
+    ssize_t n;
+    do
+        n = read((int) (intptr_t) source, into, size);
+    while (n == -1 && errno == EINTR);
+    return n > 0 ? n : 0;
+}
+
+// Reads no input, but says there will be some, to stop a run at its first read
+long input_read_later (void *source, void *into, size_t size)
+{
+    return -1;
+}
+
+// Opens output to `fd`, with input from `input_fd`, or none if that is -1
+void output_open (output_t *output, int fd, int line_buffered, int input_fd)
+{
+    output->fd = fd;
+    output->copy_fd = -1;
+    output->line_buffered = line_buffered;
+    output->into = NULL;
+    output->from_length = output->from_used = 0;
+    output->read = input_fd != -1 ? input_read_fd : NULL;
+    output->source = (void *) (intptr_t) input_fd;
+    output->used = 0;
+    active_output = output;
+}
+
+void output_open_memory (output_t *output, void *into, size_t into_size,
+                         const void *from, size_t from_length)
+{
+    output_open(output, -1, 0, -1);
+    output->into = into;
+    output->into_size = into_size;
+    output->into_used = 0;
+    output->from = from;
+    output->from_length = from_length;
+}
+
+void output_close (output_t *output)
+{
+    output_flush(output);
+    if (active_output == output)
+        active_output = NULL;
+}
+
+/* Makes room for `n` bytes, at most OUTPUT_BUFFER_SIZE, returning where
+   they go. Once stored there, `output_commit` adds them to the output. */
+static inline unsigned char *output_reserve (output_t *output, size_t n)
+{
+    if (output->used + n > OUTPUT_BUFFER_SIZE)
+        output_flush(output);
+    return output->data + output->used;
+}
+
+static inline void output_commit (output_t *output, size_t n)
+{
+    output->used += n;
+    if (output->line_buffered
+        && memchr(output->data + output->used - n, '\n', n) != NULL)
+        output_flush(output);
+}
+
+static inline void output_put (output_t *output, int c)
+{
+    *output_reserve(output, 1) = c;
+    output_commit(output, 1);
+}
+
+// What `input_get` returns when there is no input yet, but may be later
+#define INPUT_PENDING (-2)
+
+// Reads the next block of input, returning its first byte like `input_get`
+int input_refill (output_t *output)
+{
+    if (output->read == NULL)
+        return EOF;
+    long n = output->read(output->source, output->in_data, OUTPUT_BUFFER_SIZE);
+    if (n <= 0)
+        return n == 0 ? EOF : INPUT_PENDING;
+    output->from = output->in_data;
+    output->from_length = n;
+    output->from_used = 1;
+    return output->in_data[0];
+}
+
+/* Reads a byte of input, after any prompt for it when line buffered.
+   Returns EOF at the end of input, or INPUT_PENDING. */
+static inline int input_get (output_t *output)
+{
+    if (output->line_buffered)
+        output_flush(output);
+    if (output->from_used < output->from_length)
+        return output->from[output->from_used++];
+    return input_refill(output);
+}
+
+/* What BF_GET stores in a cell holding `current` when `input_get` returned
+   `c`, with `eof` saying what to do at the end of input */
+static inline uint32_t input_value (int c, int eof, uint32_t current)
+{
+    if (c >= 0)
+        return c;
+    return eof == EOF_UNCHANGED ? current : eof == EOF_ZERO ? 0 : (uint32_t) -1;
+}
+
+// Usable size in bytes of a guarded tape, and of the guards on either side
+#define GUARDED_TAPE_SIZE ((size_t) 1 << 30)
+#define GUARD_SIZE ((size_t) 1 << 26)
+
+/* A tape in one big mapping, of which only the part between the guards is
+   accessible. The OS only backs pages with memory once they are touched,
+   so a program can use as little or as much of the tape as it needs
+   without anything checking the memory pointer, while a move past either
+   end faults on a guard and is reported by `guarded_tape_fault`. */
+typedef struct {
+    char *mapping;
+    char *start;
+    char *end;
+    size_t restored; // Bytes at the start mapped from a snapshot file
+} guarded_tape_t;
+
+// The guarded tape in use by the current thread, for the fault handler
+static __thread guarded_tape_t *active_tape;
+
+// A tape unmapped by the current thread kept for its next one, all zeros
+static __thread guarded_tape_t kept_tape;
+
+
+void guarded_tape_unmap (guarded_tape_t *tape);
+
+static const char guarded_tape_before[] =
+    "Memory pointer moved before the start of the tape\n";
+static const char guarded_tape_past[] =
+    "Memory pointer moved past the end of the tape\n";
+
+/* Ends the run on the active tape with `message`, through the escape if
+   there is one. Only calls what is safe in a signal handler. */
+__attribute__((noreturn))
+void guarded_tape_leave (const char *message, size_t length)
+{
+    if (active_output != NULL)
+        output_flush(active_output);
+    write(STDERR_FILENO, message, length);
+
+    if (active_escape != NULL){
+        guarded_tape_unmap(active_tape);
+        siglongjmp(*active_escape, 1);
+    }
+    _exit(EX_SOFTWARE);
+}
+
+/* A scan to the left reads nothing below the start of the tape, so it
+   does not fault when it finds no zero there. Its result has wrapped
+   around then, and this reports it like a fault on the guard. */
+static inline void guarded_tape_scanned_left (size_t from, size_t to)
+{
+    if (to > from)
+        guarded_tape_leave(guarded_tape_before, sizeof(guarded_tape_before) - 1);
+}
+
+void guarded_tape_fault (int signum, siginfo_t *info, void *context)
+{
+    guarded_tape_t *tape = active_tape;
+    char *address = info->si_addr;
+
+    if (tape != NULL && address >= tape->mapping && address < tape->start)
+        guarded_tape_leave(guarded_tape_before, sizeof(guarded_tape_before) - 1);
+    else if (tape != NULL && address >= tape->end && address < tape->end + GUARD_SIZE)
+        guarded_tape_leave(guarded_tape_past, sizeof(guarded_tape_past) - 1);
+
+    // Not ours, fault again without this handler
+    signal(SIGSEGV, SIG_DFL);
+}
+
+int guarded_tape_map (guarded_tape_t *tape)
+{
+    size_t mapped = GUARD_SIZE + GUARDED_TAPE_SIZE + GUARD_SIZE;
+    if (kept_tape.mapping != NULL){
+        *tape = kept_tape;
+        kept_tape.mapping = NULL;
+    } else {
+        tape->mapping = mmap(NULL, mapped, PROT_NONE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (tape->mapping == MAP_FAILED)
+            return STATUS_CANNOT_MAP_MEMORY;
+        tape->start = tape->mapping + GUARD_SIZE;
+        tape->end = tape->start + GUARDED_TAPE_SIZE;
+        if (mprotect(tape->start, GUARDED_TAPE_SIZE, PROT_READ | PROT_WRITE) != 0){
+            munmap(tape->mapping, mapped);
+            return STATUS_CANNOT_MAP_MEMORY;
+        }
+    }
+    tape->restored = 0;
+
+    // Report faults on the guards, on a stack of its own to survive overflows
+    static __thread char fault_stack[1 << 16];
+    stack_t stack = {.ss_sp = fault_stack, .ss_size = sizeof(fault_stack)};
+    sigaltstack(&stack, NULL);
+    struct sigaction action = {.sa_sigaction = guarded_tape_fault,
+                               .sa_flags = SA_SIGINFO | SA_ONSTACK};
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGSEGV, &action, NULL);
+
+    active_tape = tape;
+    return STATUS_OK;
+}
+
+/* Gives back the memory of a tape. The first one is kept for the thread
+   to map again, which is cheaper than a new mapping when it runs many
+   programs. */
+void guarded_tape_unmap (guarded_tape_t *tape)
+{
+    if (active_tape == tape)
+        active_tape = NULL;
+    // Dropped pages of a file come back as they are in it, not as zeros
+    int anonymous = tape->restored == 0
+        || mmap(tape->start, tape->restored, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) != MAP_FAILED;
+    if (anonymous && kept_tape.mapping == NULL
+        && madvise(tape->start, GUARDED_TAPE_SIZE, MADV_DONTNEED) == 0)
+        kept_tape = *tape;
+    else
+        munmap(tape->mapping, GUARD_SIZE + GUARDED_TAPE_SIZE + GUARD_SIZE);
+}
+
+// Unmaps the tape kept by `guarded_tape_unmap`, before the thread ends
+void guarded_tape_drop_kept (void)
+{
+    if (kept_tape.mapping != NULL)
+        munmap(kept_tape.mapping, GUARD_SIZE + GUARDED_TAPE_SIZE + GUARD_SIZE);
+    kept_tape.mapping = NULL;
+}
+
+void reallocate_runtime_memory(void **memory, size_t *memmax, size_t memptr,
+                               size_t cell_size) {
+    // A memory pointer this far out can only have wrapped around below 0
+    if (memptr >= (SIZE_MAX >> 1) / cell_size){
+        if (active_output != NULL)
+            output_flush(active_output);
+        fputs("Memory pointer moved before the start of the tape\n",stderr);
+        if (active_escape != NULL){
+            free(*memory);
+            siglongjmp(*active_escape, 1);
+        }
+        exit(EX_SOFTWARE);
+    }
+
+    size_t new_memmax = *memmax;
+    while (memptr >= new_memmax)
+        new_memmax *=2;
+
+    *memory = realloc(*memory, new_memmax * cell_size); // Preserves old content
+
+    // Initialize the extra memory to 0
+    memset((char *) *memory + *memmax * cell_size, 0,
+           (new_memmax - *memmax) * cell_size);
+
+    // Update current maximum
+    *memmax = new_memmax;
+}
+
+/* Reading and writing cells of `cell_size` bytes. Everything using these is
+   inlined with a constant `cell_size`, so each cell width gets its own
+   specialized code without any checks on the width at runtime. */
+static inline __attribute__((always_inline))
+uint32_t cell_load (void *memory, size_t at, const size_t cell_size)
+{
+    switch(cell_size){
+    case 1:
+        return ((uint8_t *) memory)[at];
+    case 2:
+        return ((uint16_t *) memory)[at];
+    default:
+        return ((uint32_t *) memory)[at];
+    }
+}
+
+static inline __attribute__((always_inline))
+void cell_store (void *memory, size_t at, uint32_t value, const size_t cell_size)
+{
+    switch(cell_size){
+    case 1:
+        ((uint8_t *) memory)[at] = value;
+        break;
+    case 2:
+        ((uint16_t *) memory)[at] = value;
+        break;
+    default:
+        ((uint32_t *) memory)[at] = value;
+    }
+}
+
+/* Zero search for BF_SCAN to either side, on cells of `cell_size` bytes,
+   looking at every `stride`th cell. Where the distance between the
+   cells looked at is a power of two no wider than a vector, whole vectors
+   of cells are compared to zero at once, with SSE2, AVX2 or AVX-512, as
+   picked by `scan_select` for this CPU. Otherwise, and near the ends of
+   the memory, cells are looked at one at a time. */
+
+// Vector width in bytes of the kernels in use, 0 if there are none
+static size_t scan_vector = 0;
+
+/* Picks the widest kernels this CPU supports, unless FUCKED_UP_SCAN says
+   `scalar`, `sse2`, `avx2` or `avx512` */
+void scan_select (void)
+{
+#if defined(__x86_64__)
+    const char *forced = getenv("FUCKED_UP_SCAN");
+    __builtin_cpu_init();
+    if (forced != NULL)
+        scan_vector = strcmp(forced, "avx512") == 0 ? 64
+                    : strcmp(forced, "avx2") == 0 ? 32
+                    : strcmp(forced, "sse2") == 0 ? 16
+                    : 0;
+    else if (__builtin_cpu_supports("avx512bw"))
+        scan_vector = 64;
+    else if (__builtin_cpu_supports("avx2"))
+        scan_vector = 32;
+    else
+        scan_vector = 16;
+#endif
+}
+
+size_t scan_right_scalar (const unsigned char *memory, size_t at, size_t end,
+                          size_t cell_size, size_t stride)
+{
+    while (at < end && cell_load((void *) memory, at, cell_size) != 0)
+        at += stride;
+    return at;
+}
+
+size_t scan_left_scalar (const unsigned char *memory, size_t at,
+                         size_t cell_size, size_t stride)
+{
+    while (cell_load((void *) memory, at, cell_size) != 0){
+        if (at < stride)
+            return at - stride; // Wraps around, like the memory pointer would
+        at -= stride;
+    }
+    return at;
+}
+
+#if defined(__x86_64__)
+
+/* Turns a mask of zero bytes into one where the bit for the first byte of
+   each cell is set if the whole cell is zero */
+static inline __attribute__((always_inline))
+uint64_t scan_zero_cells (uint64_t zero_bytes, size_t cell_size)
+{
+    if (cell_size >= 2)
+        zero_bytes &= zero_bytes >> 1;
+    if (cell_size == 4)
+        zero_bytes &= zero_bytes >> 2;
+    return zero_bytes;
+}
+
+// Bit i is set for every byte i that is a multiple of `bytes`
+static inline __attribute__((always_inline))
+uint64_t scan_pattern (size_t bytes)
+{
+    static const uint64_t patterns[] = {
+        0xffffffffffffffff, 0x5555555555555555, 0x1111111111111111,
+        0x0101010101010101, 0x0001000100010001, 0x0000000100000001,
+        0x0000000000000001,
+    };
+    return patterns[__builtin_ctzll(bytes)];
+}
+
+__attribute__((target("sse2"))) static inline
+uint64_t scan_zero_bytes_sse2 (const unsigned char *p)
+{
+    __m128i bytes = _mm_loadu_si128((const __m128i *) p);
+    return (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_setzero_si128()));
+}
+
+__attribute__((target("avx2"))) static inline
+uint64_t scan_zero_bytes_avx2 (const unsigned char *p)
+{
+    __m256i bytes = _mm256_loadu_si256((const __m256i *) p);
+    return (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_setzero_si256()));
+}
+
+__attribute__((target("avx512f,avx512bw"))) static inline
+uint64_t scan_zero_bytes_avx512 (const unsigned char *p)
+{
+    __m512i bytes = _mm512_loadu_si512((const void *) p);
+    return _mm512_cmpeq_epi8_mask(bytes, _mm512_setzero_si512());
+}
+
+/* The kernels, for `vector` bytes at a time. A vector loaded at a cell
+   holds candidates at the same places every time, since `cell_size *
+   stride` divides `vector`. */
+#define SCAN_KERNELS(isa, vector, features)                                 \
+__attribute__((target(features)))                                           \
+size_t scan_right_##isa (const unsigned char *memory, size_t at,            \
+                         size_t end, size_t cell_size, size_t stride)       \
+{                                                                           \
+    uint64_t pattern = scan_pattern(cell_size * stride);                    \
+    size_t limit = end * cell_size;                                         \
+    size_t byte = at * cell_size;                                           \
+    for (; byte + vector <= limit; byte += vector){                         \
+        uint64_t zeros = scan_zero_cells(                                   \
+            scan_zero_bytes_##isa(memory + byte), cell_size) & pattern;     \
+        if (zeros != 0)                                                     \
+            return (byte + __builtin_ctzll(zeros)) / cell_size;             \
+    }                                                                       \
+    return scan_right_scalar(memory, byte / cell_size, end,                 \
+                             cell_size, stride);                            \
+}                                                                           \
+__attribute__((target(features)))                                           \
+size_t scan_left_##isa (const unsigned char *memory, size_t at,             \
+                        size_t cell_size, size_t stride)                    \
+{                                                                           \
+    size_t bytes = cell_size * stride;                                      \
+    uint64_t pattern = scan_pattern(bytes) << (bytes - cell_size);          \
+    size_t byte = (at + 1) * cell_size; /* Just past the vector */          \
+    for (; byte >= vector; byte -= vector){                                 \
+        uint64_t zeros = scan_zero_cells(                                   \
+            scan_zero_bytes_##isa(memory + byte - vector), cell_size)       \
+            & pattern;                                                      \
+        if (zeros != 0)                                                     \
+            return (byte - vector + 63 - __builtin_clzll(zeros)) / cell_size; \
+    }                                                                       \
+    if (byte == 0) /* Past the start, wrap around like the memory pointer */\
+        return at - (at / stride + 1) * stride;                             \
+    return scan_left_scalar(memory, byte / cell_size - 1,                   \
+                            cell_size, stride);                             \
+}
+
+SCAN_KERNELS(sse2, 16, "sse2")
+SCAN_KERNELS(avx2, 32, "avx2")
+SCAN_KERNELS(avx512, 64, "avx512f,avx512bw")
+#endif
+
+// Whether the vector kernels can scan with `cell_size` and `stride`
+static inline int scan_vectorizable (size_t cell_size, size_t stride)
+{
+    size_t bytes = cell_size * stride;
+    return (bytes & (bytes - 1)) == 0 && bytes <= scan_vector;
+}
+
+/* Index of the first zero cell of `at`, `at + stride`, ... before `end`,
+   or of the first of those at or past `end`, which are zero too if the
+   memory is grown to reach them */
+size_t bf_scan_right (const void *memory, size_t at, size_t end,
+                      size_t cell_size, size_t stride)
+{
+    // Often enough there is nothing to scan
+    if (at >= end || cell_load((void *) memory, at, cell_size) == 0)
+        return at;
+#if defined(__x86_64__)
+    if (scan_vectorizable(cell_size, stride)){
+        switch(scan_vector){
+        case 64:
+            return scan_right_avx512(memory, at, end, cell_size, stride);
+        case 32:
+            return scan_right_avx2(memory, at, end, cell_size, stride);
+        case 16:
+            return scan_right_sse2(memory, at, end, cell_size, stride);
+        }
+    }
+#endif
+    return scan_right_scalar(memory, at, end, cell_size, stride);
+}
+
+/* Index of the first zero cell of `at`, `at - stride`, ..., or if there is
+   none the first of those below 0, wrapped around */
+size_t bf_scan_left (const void *memory, size_t at,
+                     size_t cell_size, size_t stride)
+{
+    if (cell_load((void *) memory, at, cell_size) == 0)
+        return at;
+#if defined(__x86_64__)
+    if (scan_vectorizable(cell_size, stride)){
+        switch(scan_vector){
+        case 64:
+            return scan_left_avx512(memory, at, cell_size, stride);
+        case 32:
+            return scan_left_avx2(memory, at, cell_size, stride);
+        case 16:
+            return scan_left_sse2(memory, at, cell_size, stride);
+        }
+    }
+#endif
+    return scan_left_scalar(memory, at, cell_size, stride);
+}
+
+/* A run that went back to the start of its loops `budget` times stops
+   before doing so again, so it can be resumed later where it stopped. That way runs
+   can take turns on a thread, or be held to a quota, at the cost of
+   counting taken BF_LOOP_ENDs: a program cannot run for long without
+   them. In between, the run keeps its tape here, and for the JIT its
+   machine code, with the offset in it of every instruction in `native`.
+   The machine code reaches `budget`, `insptr` and `cell` by byte offsets,
+   so they come first. */
+typedef struct {
+    long budget;
+    size_t insptr;     // Where the run goes on
+    char *cell;        // Where the JIT was on the tape when it stopped
+    size_t memptr;
+    size_t memmax;
+    void *memory;      // The tape, NULL before the run starts and after it
+    int tape_mode;
+    guarded_tape_t tape;
+    void *code;
+    size_t code_size;
+    size_t *native;
+} bf_slice_t;
+
+/* Runs the program contained in a bf_data_t, for cells of `cell_size` bytes
+   on a tape in `tape_mode`, guarded (see `guarded_tape_t`), bounded (see
+   `bounds`) or grown as needed. Unless `counts` is NULL it counts how often
+   every instruction is run. Unless `slice` is NULL the run goes on from
+   where it stopped, if it did, for its budget. */
+static inline __attribute__((always_inline))
+int bf_data_run_cells (bf_data_t *bf_data, output_t *output,
+                       const size_t cell_size, const int tape_mode,
+                       uint64_t *const counts, void *const fixed,
+                       const size_t fixed_cells, bf_slice_t *const slice)
+{
+    // Current place in instruction space
+    size_t insptr = 0;
+
+    // Maximum and current index in memory space
+    size_t memmax = 1;
+    size_t memptr = 0;
+
+    void *memory;
+    guarded_tape_t own_tape;
+    guarded_tape_t *tape = slice != NULL ? &slice->tape : &own_tape;
+    long budget = slice != NULL ? slice->budget : 0;
+    int status = STATUS_OK;
+    if (slice != NULL && slice->memory != NULL){
+        insptr = slice->insptr;
+        memptr = slice->memptr;
+        memmax = slice->memmax;
+        memory = slice->memory;
+        if (tape_mode == TAPE_GUARDED)
+            active_tape = tape;
+    } else if (fixed != NULL){
+        // Only the part a bounded program can reach needs to be cleared
+        memory = fixed;
+        memmax = fixed_cells;
+        memset(memory, 0, (tape_mode == TAPE_BOUNDED
+                           ? bf_data->tape_cells : memmax) * cell_size);
+    } else if (tape_mode == TAPE_GUARDED){
+        if (guarded_tape_map(tape) != STATUS_OK)
+            return STATUS_CANNOT_MAP_MEMORY;
+        memory = tape->start;
+        memmax = GUARDED_TAPE_SIZE / cell_size;
+    } else {
+        if (tape_mode == TAPE_BOUNDED)
+            memmax = bf_data->tape_cells;
+        memory = calloc(memmax,cell_size);
+    }
+
+    // Makes sure memory reaches index `at`
+#define FIT(at) \
+    if (tape_mode == TAPE_DYNAMIC && (at) >= memmax) \
+        reallocate_runtime_memory(&memory, &memmax, (at), cell_size); \
+    else if (tape_mode == TAPE_FIXED && (at) >= memmax) \
+        goto left_tape
+#define LOAD(at) cell_load(memory, (at), cell_size)
+#define STORE(at, value) cell_store(memory, (at), (value), cell_size)
+
+    const bf_op_t *ops = bf_data->ops;
+    for (;; insptr++){
+        const bf_op_t *op = ops + insptr;
+        size_t at = memptr + op->offset;
+        if (counts)
+            counts[insptr]++;
+        switch(op->op){
+        case BF_ADD:
+            FIT(at);
+            STORE(at, LOAD(at) + op->arg);
+            break;
+        case BF_MOVE:
+            memptr += op->arg;
+            FIT(memptr);
+            break;
+        case BF_GET: {
+            FIT(at);
+            int c = input_get(output);
+            if (slice != NULL && c == INPUT_PENDING){
+                status = STATUS_NEEDS_INPUT;
+                goto suspend;
+            }
+            STORE(at, input_value(c, bf_data->eof, LOAD(at)));
+            break;
+        }
+        case BF_PUT:
+            FIT(at);
+            output_put(output, LOAD(at));
+            break;
+        case BF_LOOP_START:
+            if (LOAD(memptr) == 0)
+                insptr = op->arg;
+            break;
+        case BF_LOOP_END:
+            if (LOAD(memptr) != 0){
+                // Out of budget, stop before going back
+                if (slice != NULL && --budget < 0){
+                    status = STATUS_SUSPENDED;
+                    goto suspend;
+                }
+                insptr = op->arg;
+            }
+            break;
+        case BF_CLEAR:
+            FIT(at);
+            STORE(at, 0);
+            break;
+        case BF_SET:
+            FIT(at);
+            STORE(at, op->arg);
+            break;
+        case BF_WRITE: {
+            unsigned char *to = output_reserve(output, op->arg);
+            for (int term = 1; term <= op->arg; term++)
+                to[term - 1] = op[term].arg;
+            output_commit(output, op->arg);
+            insptr += op->arg;
+            break;
+        }
+        case BF_SCAN:
+            if (op->arg > 0)
+                memptr = bf_scan_right(memory, memptr, memmax, cell_size,
+                                       op->arg);
+            else {
+                size_t from = memptr;
+                memptr = bf_scan_left(memory, from, cell_size, -op->arg);
+                if (tape_mode == TAPE_GUARDED)
+                    guarded_tape_scanned_left(from, memptr);
+            }
+            FIT(memptr); // Only when it went past either end of the tape
+            break;
+        case BF_MUL_ADD: {
+            FIT(at);
+            uint32_t value = LOAD(at);
+            if (value != 0){
+                for (int term = 1; term <= op->arg; term++){
+                    size_t to = memptr + op[term].offset;
+                    FIT(to);
+                    STORE(to, LOAD(to) + value * op[term].arg);
+                }
+                STORE(at, 0);
+            }
+            insptr += op->arg;
+            break;
+        }
+        case BF_PUT_RUN: {
+            unsigned char *to = output_reserve(output, op->arg);
+            for (int term = 1; term <= op->arg; term++){
+                at = memptr + op[term].offset;
+                FIT(at);
+                to[term - 1] = LOAD(at);
+            }
+            output_commit(output, op->arg);
+            insptr += op->arg;
+            break;
+        }
+        case BF_FIT:
+            FIT(memptr + op->arg);
+            break;
+        case BF_END:
+            goto done;
+        }
+    }
+suspend:
+    slice->budget = budget < 0 ? 0 : budget;
+    slice->insptr = insptr;
+    slice->memptr = memptr;
+    slice->memmax = memmax;
+    slice->memory = memory;
+    slice->tape_mode = fixed != NULL ? TAPE_FIXED : tape_mode;
+    if (active_tape == tape)
+        active_tape = NULL;
+    return status;
+left_tape:
+    status = STATUS_LEFT_TAPE;
+done:
+
+#undef STORE
+#undef LOAD
+#undef FIT
+
+    if (slice != NULL){
+        slice->budget = budget;
+        slice->memory = NULL;
+    }
+
+    // Free the memory, unless it is the caller's
+    if (fixed == NULL && tape_mode == TAPE_GUARDED)
+        guarded_tape_unmap(tape);
+    else if (fixed == NULL)
+        free(memory);
+
+    return status;
+}
+
+// Runs `bf_data_run_cells` as the tape mode and cell size of a bf_data_t say
+static inline __attribute__((always_inline))
+int bf_data_run_tape (bf_data_t *bf_data, output_t *output,
+                      bf_slice_t *const slice)
+{
+    int tape_mode = bf_data->tape_mode;
+    if (tape_mode == TAPE_DYNAMIC && bf_data->tape_cells != 0)
+        tape_mode = TAPE_BOUNDED;
+
+#define RUN(cell_size) \
+    return tape_mode == TAPE_GUARDED \
+        ? bf_data_run_cells(bf_data, output, cell_size, TAPE_GUARDED, NULL, NULL, 0, slice) \
+        : tape_mode == TAPE_BOUNDED \
+        ? bf_data_run_cells(bf_data, output, cell_size, TAPE_BOUNDED, NULL, NULL, 0, slice) \
+        : bf_data_run_cells(bf_data, output, cell_size, TAPE_DYNAMIC, NULL, NULL, 0, slice)
+
+    switch(bf_data->cell_size){
+    case 1:
+        RUN(1);
+    case 2:
+        RUN(2);
+    default:
+        RUN(4);
+    }
+#undef RUN
+}
+
+// Runs the program contained in a bf_data_t
+int bf_data_run (bf_data_t *bf_data, output_t *output)
+{
+    return bf_data_run_tape(bf_data, output, NULL);
+}
+
+/* Runs the program contained in a bf_data_t like `bf_data_run` for a slice
+   of `slice->budget` back edges, starting the run unless it is suspended.
+   Returns STATUS_SUSPENDED if it did not end, and can be called again to
+   go on with it. */
+int bf_data_run_slice (bf_data_t *bf_data, output_t *output, bf_slice_t *slice)
+{
+    return bf_data_run_tape(bf_data, output, slice);
+}
+
+/* Gives back what a suspended run kept, when it is not going to be
+   resumed. After an escape its tape is gone already, and `memory` needs
+   to be set to NULL first. */
+void bf_slice_drop (bf_slice_t *slice)
+{
+    if (slice->memory != NULL && slice->tape_mode == TAPE_GUARDED)
+        guarded_tape_unmap(&slice->tape);
+    else if (slice->memory != NULL && slice->tape_mode != TAPE_FIXED)
+        free(slice->memory);
+    if (slice->code != NULL)
+        munmap(slice->code, slice->code_size);
+    free(slice->native);
+    slice->memory = NULL;
+    slice->code = NULL;
+    slice->native = NULL;
+}
+
+/* Runs the program contained in a bf_data_t like `bf_data_run`, adding
+   how often every instruction is run to `counts`, one per bf_op_t */
+int bf_data_run_counted (bf_data_t *bf_data, output_t *output, uint64_t *counts)
+{
+    int guarded = bf_data->tape_mode == TAPE_GUARDED;
+    switch(bf_data->cell_size){
+    case 1:
+        return guarded ? bf_data_run_cells(bf_data, output, 1, TAPE_GUARDED, counts, NULL, 0, NULL)
+                       : bf_data_run_cells(bf_data, output, 1, TAPE_DYNAMIC, counts, NULL, 0, NULL);
+    case 2:
+        return guarded ? bf_data_run_cells(bf_data, output, 2, TAPE_GUARDED, counts, NULL, 0, NULL)
+                       : bf_data_run_cells(bf_data, output, 2, TAPE_DYNAMIC, counts, NULL, 0, NULL);
+    default:
+        return guarded ? bf_data_run_cells(bf_data, output, 4, TAPE_GUARDED, counts, NULL, 0, NULL)
+                       : bf_data_run_cells(bf_data, output, 4, TAPE_DYNAMIC, counts, NULL, 0, NULL);
+    }
+}
+
+/* Profiles list the loops that the most instructions were run in, counting
+   those of the loops nested in them, with how often they were entered and
+   went around. Loops that `peephole` replaced by one instruction are in
+   there as well, as that instruction. */
+
+// A loop in a profile, identified by the index of its first instruction
+typedef struct {
+    size_t start;
+    uint64_t instructions;
+} profile_loop_t;
+
+int profile_loop_compare (const void *a, const void *b)
+{
+    const profile_loop_t *x = a, *y = b;
+    if (x->instructions != y->instructions)
+        return x->instructions < y->instructions ? 1 : -1;
+    return (x->start > y->start) - (x->start < y->start);
+}
+
+/* The loops of the program in a bf_data_t in the order they come in, with
+   the instructions run in them from the `counts` of a run. Sets `found` to
+   how many there are, and `total` to the instructions run overall. */
+profile_loop_t *profile_loops (bf_data_t *bf_data, const uint64_t *counts,
+                               size_t *found, uint64_t *total)
+{
+    const bf_op_t *ops = bf_data->ops;
+
+    // Instructions run before each one, so a loop is a difference of two
+    uint64_t *before = malloc((bf_data->length + 1) * sizeof(uint64_t));
+    profile_loop_t *loops = malloc((bf_data->length + 1) * sizeof(profile_loop_t));
+    *found = 0;
+    before[0] = 0;
+    for (size_t i = 0; i < bf_data->length; i++){
+        before[i + 1] = before[i] + counts[i];
+        switch (ops[i].op){
+        case BF_LOOP_START:
+        case BF_CLEAR:
+        case BF_SCAN:
+        case BF_MUL_ADD:
+            loops[(*found)++] = (profile_loop_t) {i, 0};
+        }
+    }
+    for (size_t l = 0; l < *found; l++){
+        size_t start = loops[l].start;
+        size_t end = ops[start].op == BF_LOOP_START ? ops[start].arg : start;
+        loops[l].instructions = before[end + 1] - before[start];
+    }
+    *total = before[bf_data->length];
+    free(before);
+    return loops;
+}
+
+/* Writes the `top` loops of a profile to `report`, from the `counts` of a
+   run of the program in a bf_data_t that kept its positions */
+void profile_report (bf_data_t *bf_data, const uint64_t *counts, int top,
+                     FILE *report)
+{
+    const bf_op_t *ops = bf_data->ops;
+    size_t found;
+    uint64_t total;
+    profile_loop_t *loops = profile_loops(bf_data, counts, &found, &total);
+    qsort(loops, found, sizeof(profile_loop_t), profile_loop_compare);
+
+    fprintf(report, "Profile: %llu instructions run, the hottest loops are\n"
+            "%14s %14s %14s %16s %7s\n", (unsigned long long) total,
+            "line:column", "entries", "iterations", "instructions", "share");
+    for (size_t l = 0; l < found && l < (size_t) top; l++){
+        size_t start = loops[l].start;
+        if (loops[l].instructions == 0)
+            break;
+
+        char position[32];
+        snprintf(position, sizeof(position), "%u:%u",
+                 bf_data->positions[start].line, bf_data->positions[start].column);
+        fprintf(report, "%14s %14llu ", position,
+                (unsigned long long) counts[start]);
+        if (ops[start].op == BF_LOOP_START)
+            fprintf(report, "%14llu", (unsigned long long) counts[ops[start].arg]);
+        else
+            fprintf(report, "%14s", "-");
+
+        static const char *const names[BF_OPCODES] = {
+            [BF_LOOP_START] = "loop", [BF_CLEAR] = "clear",
+            [BF_SCAN] = "scan", [BF_MUL_ADD] = "multiply",
+        };
+        fprintf(report, " %16llu %6.1f%%  %s\n",
+                (unsigned long long) loops[l].instructions,
+                100.0 * loops[l].instructions / total, names[ops[start].op]);
+    }
+
+    free(loops);
+}
+
+/* The sequences of 2 or 3 instructions that can be superinstructions,
+   those without BF_TERMs, can be listed by how often they ran in one go:
+   at most as often as the least run of them, which is taken for it, as
+   that is all that fusing them saves. Their opcodes are packed into the
+   bytes of `ops`, the first in the lowest. */
+typedef struct {
+    uint32_t ops;
+    uint64_t runs;
+} sequence_t;
+
+// Names of the opcodes, as in superinstructions.h but in lower case
+static const char *const bf_opcode_names[BF_OPCODES] = {
+    [BF_END] = "end", [BF_ADD] = "add", [BF_MOVE] = "move", [BF_GET] = "get",
+    [BF_PUT] = "put", [BF_LOOP_START] = "loop_start",
+    [BF_LOOP_END] = "loop_end", [BF_CLEAR] = "clear", [BF_SCAN] = "scan",
+    [BF_MUL_ADD] = "mul_add", [BF_SET] = "set", [BF_WRITE] = "write",
+    [BF_PUT_RUN] = "put_run", [BF_FIT] = "fit", [BF_TERM] = "term",
+};
+
+int sequence_fusable (int op)
+{
+    return op != BF_END && op != BF_MUL_ADD && op != BF_WRITE
+        && op != BF_PUT_RUN && op != BF_TERM;
+}
+
+int sequence_compare_ops (const void *a, const void *b)
+{
+    const sequence_t *x = a, *y = b;
+    return (x->ops > y->ops) - (x->ops < y->ops);
+}
+
+int sequence_compare_runs (const void *a, const void *b)
+{
+    const sequence_t *x = a, *y = b;
+    if (x->runs != y->runs)
+        return x->runs < y->runs ? 1 : -1;
+    return sequence_compare_ops(a, b);
+}
+
+/* Writes the `top` sequences that ran most to `report`, from the `counts`
+   of a run of the program in a bf_data_t, with their share of all the
+   instructions run. `make superinstructions` adds these up over tests/. */
+void sequence_report (bf_data_t *bf_data, const uint64_t *counts, int top,
+                      FILE *report)
+{
+    const bf_op_t *ops = bf_data->ops;
+    sequence_t *sequences = malloc(2 * (bf_data->length + 1) * sizeof(sequence_t));
+    size_t found = 0;
+    uint64_t total = 0;
+    for (size_t i = 0; i < bf_data->length; i++){
+        total += counts[i];
+        uint32_t packed = 0;
+        uint64_t runs = UINT64_MAX;
+        for (size_t n = 0; n < 3 && i + n < bf_data->length
+                 && sequence_fusable(ops[i + n].op); n++){
+            packed |= (uint32_t) ops[i + n].op << (8 * n);
+            runs = counts[i + n] < runs ? counts[i + n] : runs;
+            if (n > 0 && runs > 0)
+                sequences[found++] = (sequence_t) {packed, runs};
+        }
+    }
+
+    // The same sequence in different places runs as one
+    qsort(sequences, found, sizeof(sequence_t), sequence_compare_ops);
+    size_t merged = 0;
+    for (size_t i = 0; i < found; i++){
+        if (merged > 0 && sequences[merged - 1].ops == sequences[i].ops)
+            sequences[merged - 1].runs += sequences[i].runs;
+        else
+            sequences[merged++] = sequences[i];
+    }
+    qsort(sequences, merged, sizeof(sequence_t), sequence_compare_runs);
+
+    fprintf(report, "Sequences: %llu instructions run, the most run ones that can be superinstructions are\n"
+            "%14s %7s  %s\n", (unsigned long long) total, "runs", "share",
+            "instructions");
+    for (size_t i = 0; i < merged && i < (size_t) top; i++){
+        fprintf(report, "%14llu %6.2f%% ", (unsigned long long) sequences[i].runs,
+                100.0 * sequences[i].runs / total);
+        for (uint32_t packed = sequences[i].ops; packed != 0; packed >>= 8)
+            fprintf(report, " %s", bf_opcode_names[packed & 0xff]);
+        fputc('\n', report);
+    }
+    free(sequences);
+}
+
+// Instruction in threaded code, its handler and its operands
+typedef struct bf_thread {
+    void *handler;
+    union {
+        struct {
+            int32_t offset;
+            int32_t arg;
+        };
+        struct bf_thread *jump; // Loop constructs, to after the matching one
+    };
+} bf_thread_t;
+
+/* What the instructions without BF_TERMs do in threaded code for cells of
+   type `cell_t`, as the `k`th in a handler after `ip`, growing the tape if
+   `checked`. Loop constructs that jump leave the rest of the handler out. */
+#define THREADED_END(cell_t, checked, k)
+#define THREADED_ADD(cell_t, checked, k)                                \
+    at = memptr + ip[k].offset;                                         \
+    FIT(at, checked);                                                   \
+    ((cell_t *) memory)[at] += ip[k].arg;
+#define THREADED_MOVE(cell_t, checked, k)                               \
+    memptr += ip[k].arg;                                                \
+    FIT(memptr, checked);
+#define THREADED_GET(cell_t, checked, k)                                \
+    at = memptr + ip[k].offset;                                         \
+    FIT(at, checked);                                                   \
+    ((cell_t *) memory)[at] = input_value(input_get(output), eof,       \
+                                          ((cell_t *) memory)[at]);
+#define THREADED_PUT(cell_t, checked, k)                                \
+    at = memptr + ip[k].offset;                                         \
+    FIT(at, checked);                                                   \
+    output_put(output, ((cell_t *) memory)[at]);
+#define THREADED_LOOP_START(cell_t, checked, k)                         \
+    if (((cell_t *) memory)[memptr] == 0){                              \
+        ip = ip[k].jump;                                                \
+        DISPATCH(0);                                                    \
+    }
+#define THREADED_LOOP_END(cell_t, checked, k)                           \
+    if (((cell_t *) memory)[memptr] != 0){                              \
+        ip = ip[k].jump;                                                \
+        DISPATCH(0);                                                    \
+    }
+#define THREADED_CLEAR(cell_t, checked, k)                              \
+    at = memptr + ip[k].offset;                                         \
+    FIT(at, checked);                                                   \
+    ((cell_t *) memory)[at] = 0;
+#define THREADED_SET(cell_t, checked, k)                                \
+    at = memptr + ip[k].offset;                                         \
+    FIT(at, checked);                                                   \
+    ((cell_t *) memory)[at] = ip[k].arg;
+#define THREADED_SCAN(cell_t, checked, k)                               \
+    if (ip[k].arg > 0)                                                  \
+        memptr = bf_scan_right(memory, memptr, memmax, sizeof(cell_t),  \
+                               ip[k].arg);                              \
+    else {                                                              \
+        at = memptr;                                                    \
+        memptr = bf_scan_left(memory, at, sizeof(cell_t), -ip[k].arg);  \
+        if (!(checked))                                                 \
+            guarded_tape_scanned_left(at, memptr);                      \
+    }                                                                   \
+    FIT(memptr, checked);
+#define THREADED_FIT(cell_t, checked, k)                                \
+    FIT(memptr + ip[k].arg, checked);
+
+/* Handler of a superinstruction from superinstructions.h: the instructions
+   of a sequence the programs in tests/ run often, in one dispatch */
+#define THREADED_SUPER(name, n, a, b, c, cell_t, w, checked)            \
+do_##name##_##w:                                                        \
+    THREADED_##a(cell_t, checked, 0)                                    \
+    THREADED_##b(cell_t, checked, 1)                                    \
+    THREADED_##c(cell_t, checked, 2)                                    \
+    DISPATCH(n);
+
+/* Handlers of `bf_data_run_threaded` for cells of type `cell_t`, with
+   labels ending in `_w`, which grow the tape if `checked`. Functions
+   containing handlers like these cannot be inlined, so this is what gives
+   each cell width and tape mode its own handlers. */
+#define THREADED_HANDLERS(cell_t, w, checked)                           \
+do_add_##w:                                                             \
+    THREADED_ADD(cell_t, checked, 0)                                    \
+    DISPATCH(1);                                                        \
+do_move_##w:                                                            \
+    THREADED_MOVE(cell_t, checked, 0)                                   \
+    DISPATCH(1);                                                        \
+do_get_##w:                                                             \
+    THREADED_GET(cell_t, checked, 0)                                    \
+    DISPATCH(1);                                                        \
+do_put_##w:                                                             \
+    THREADED_PUT(cell_t, checked, 0)                                    \
+    DISPATCH(1);                                                        \
+do_loop_start_##w:                                                      \
+    THREADED_LOOP_START(cell_t, checked, 0)                             \
+    DISPATCH(1);                                                        \
+do_loop_end_##w:                                                        \
+    THREADED_LOOP_END(cell_t, checked, 0)                               \
+    DISPATCH(1);                                                        \
+do_clear_##w:                                                           \
+    THREADED_CLEAR(cell_t, checked, 0)                                  \
+    DISPATCH(1);                                                        \
+do_set_##w:                                                             \
+    THREADED_SET(cell_t, checked, 0)                                    \
+    DISPATCH(1);                                                        \
+do_write_##w:                                                           \
+    to = output_reserve(output, ip->arg);                               \
+    for (term = 1; term <= ip->arg; term++)                             \
+        to[term - 1] = ip[term].arg;                                    \
+    output_commit(output, ip->arg);                                     \
+    DISPATCH(1 + ip->arg);                                              \
+do_scan_##w:                                                            \
+    THREADED_SCAN(cell_t, checked, 0)                                   \
+    DISPATCH(1);                                                        \
+do_mul_add_##w:                                                         \
+    at = memptr + ip->offset;                                           \
+    FIT(at, checked);                                                   \
+    if ((value = ((cell_t *) memory)[at]) != 0){                        \
+        for (term = 1; term <= ip->arg; term++){                        \
+            size_t to = memptr + ip[term].offset;                       \
+            FIT(to, checked);                                           \
+            ((cell_t *) memory)[to] += value * ip[term].arg;            \
+        }                                                               \
+        ((cell_t *) memory)[at] = 0;                                    \
+    }                                                                   \
+    DISPATCH(1 + ip->arg);                                              \
+do_put_run_##w:                                                         \
+    to = output_reserve(output, ip->arg);                               \
+    for (term = 1; term <= ip->arg; term++){                            \
+        at = memptr + ip[term].offset;                                  \
+        FIT(at, checked);                                               \
+        to[term - 1] = ((cell_t *) memory)[at];                         \
+    }                                                                   \
+    output_commit(output, ip->arg);                                     \
+    DISPATCH(1 + ip->arg);                                              \
+do_fit_##w:                                                             \
+    THREADED_FIT(cell_t, checked, 0)                                    \
+    DISPATCH(1);                                                        \
+    SUPERINSTRUCTIONS(THREADED_SUPER, cell_t, w, checked)
+
+// Handler addresses of THREADED_HANDLERS, indexed by opcode
+#define THREADED_TABLE(w)                       \
+    {                                           \
+        [BF_END]        = &&do_end,             \
+        [BF_ADD]        = &&do_add_##w,         \
+        [BF_MOVE]       = &&do_move_##w,        \
+        [BF_GET]        = &&do_get_##w,         \
+        [BF_PUT]        = &&do_put_##w,         \
+        [BF_LOOP_START] = &&do_loop_start_##w,  \
+        [BF_LOOP_END]   = &&do_loop_end_##w,    \
+        [BF_CLEAR]      = &&do_clear_##w,       \
+        [BF_SCAN]       = &&do_scan_##w,        \
+        [BF_MUL_ADD]    = &&do_mul_add_##w,     \
+        [BF_SET]        = &&do_set_##w,         \
+        [BF_WRITE]      = &&do_write_##w,       \
+        [BF_PUT_RUN]    = &&do_put_run_##w,     \
+        [BF_FIT]        = &&do_fit_##w,         \
+    }
+
+// Handler addresses of the superinstructions, in the order they are listed
+#define THREADED_SUPER_ADDRESS(name, n, a, b, c, w) &&do_##name##_##w,
+
+// Length and opcodes of a superinstruction, for picking it
+#define SUPERINSTRUCTION_PATTERN(name, n, a, b, c, _) {n, {BF_##a, BF_##b, BF_##c}},
+
+typedef struct {
+    size_t length;
+    uint8_t ops[3];
+} superinstruction_t;
+
+static const superinstruction_t superinstructions[] = {
+    SUPERINSTRUCTIONS(SUPERINSTRUCTION_PATTERN, _)
+};
+
+#define SUPERINSTRUCTION_COUNT (sizeof(superinstructions) / sizeof(superinstructions[0]))
+
+/* The superinstruction the instructions at `ops` start with, the longest
+   if there are several, or -1 if none. Runs of fewer than `left`
+   instructions are not looked at. */
+int superinstruction_find (const bf_op_t *ops, size_t left)
+{
+    int found = -1;
+    for (size_t s = 0; s < SUPERINSTRUCTION_COUNT; s++){
+        const superinstruction_t *super = superinstructions + s;
+        size_t k = 0;
+        while (k < super->length && k < left && ops[k].op == super->ops[k])
+            k++;
+        if (k == super->length
+            && (found == -1 || super->length > superinstructions[found].length))
+            found = s;
+    }
+    return found;
+}
+
+/* Runs the program contained in a bf_data_t like `bf_data_run`, but with
+   direct threading: instruction space is first translated to an array
+   of handler addresses with their operands, every handler then jumps
+   straight to the next one. Instructions keep their index, loop
+   constructs jump by pointer. Instructions `bounds` proved to stay on the
+   tape get the handlers that do not check it. Runs of instructions that
+   are superinstructions get their handler in the first one, picked from
+   the start greedily, while the others keep theirs for jumps there. */
+int bf_data_run_threaded (bf_data_t *bf_data, output_t *output)
+{
+    static void *const handlers_8[BF_OPCODES] = THREADED_TABLE(8);
+    static void *const handlers_16[BF_OPCODES] = THREADED_TABLE(16);
+    static void *const handlers_32[BF_OPCODES] = THREADED_TABLE(32);
+    static void *const handlers_8g[BF_OPCODES] = THREADED_TABLE(8g);
+    static void *const handlers_16g[BF_OPCODES] = THREADED_TABLE(16g);
+    static void *const handlers_32g[BF_OPCODES] = THREADED_TABLE(32g);
+    static void *const supers_8[] = {SUPERINSTRUCTIONS(THREADED_SUPER_ADDRESS, 8)};
+    static void *const supers_16[] = {SUPERINSTRUCTIONS(THREADED_SUPER_ADDRESS, 16)};
+    static void *const supers_32[] = {SUPERINSTRUCTIONS(THREADED_SUPER_ADDRESS, 32)};
+    static void *const supers_8g[] = {SUPERINSTRUCTIONS(THREADED_SUPER_ADDRESS, 8g)};
+    static void *const supers_16g[] = {SUPERINSTRUCTIONS(THREADED_SUPER_ADDRESS, 16g)};
+    static void *const supers_32g[] = {SUPERINSTRUCTIONS(THREADED_SUPER_ADDRESS, 32g)};
+
+    const size_t cell_size = bf_data->cell_size;
+    const int guarded = bf_data->tape_mode == TAPE_GUARDED;
+    const int eof = bf_data->eof;
+    void *const *unchecked = cell_size == 1 ? handlers_8g
+                           : cell_size == 2 ? handlers_16g : handlers_32g;
+    void *const *handlers = guarded ? unchecked
+                          : cell_size == 1 ? handlers_8
+                          : cell_size == 2 ? handlers_16 : handlers_32;
+    void *const *unchecked_supers = cell_size == 1 ? supers_8g
+                                  : cell_size == 2 ? supers_16g : supers_32g;
+    void *const *supers = guarded ? unchecked_supers
+                        : cell_size == 1 ? supers_8
+                        : cell_size == 2 ? supers_16 : supers_32;
+
+    const bf_op_t *ops = bf_data->ops;
+    bf_thread_t *code = calloc(bf_data->length + 1, sizeof(bf_thread_t));
+
+    for (size_t i = 0; i <= bf_data->length; i++){
+        code[i].handler = ops[i].flags & BF_FLAG_BOUNDED ? unchecked[ops[i].op]
+                                                         : handlers[ops[i].op];
+        if (ops[i].op == BF_LOOP_START || ops[i].op == BF_LOOP_END)
+            code[i].jump = code + ops[i].arg + 1;
+        else {
+            code[i].offset = ops[i].offset;
+            code[i].arg = ops[i].arg;
+        }
+    }
+    for (size_t i = 0; i < bf_data->length; i++){
+        int found = superinstruction_find(ops + i, bf_data->length - i);
+        if (found == -1)
+            continue;
+        size_t length = superinstructions[found].length;
+        int bounded = 1;
+        for (size_t k = 0; k < length; k++)
+            bounded &= (ops[i + k].flags & BF_FLAG_BOUNDED) != 0;
+        code[i].handler = bounded ? unchecked_supers[found] : supers[found];
+        i += length - 1;
+    }
+
+    // Maximum and current index in memory space
+    size_t memmax = 1;
+    size_t memptr = 0;
+
+    void *memory;
+    guarded_tape_t tape;
+    if (guarded){
+        if (guarded_tape_map(&tape) != STATUS_OK){
+            free(code);
+            return STATUS_CANNOT_MAP_MEMORY;
+        }
+        memory = tape.start;
+        memmax = GUARDED_TAPE_SIZE / cell_size;
+    } else {
+        if (bf_data->tape_cells != 0)
+            memmax = bf_data->tape_cells;
+        memory = calloc(memmax,cell_size);
+    }
+
+    // Makes sure memory reaches index `at`, unless the tape is guarded
+#define FIT(at, checked) \
+    if ((checked) && (at) >= memmax) \
+        reallocate_runtime_memory(&memory, &memmax, (at), cell_size)
+
+    // Continues with the handler `n` slots further
+#define DISPATCH(n) \
+    ip += (n); goto *ip->handler
+
+    bf_thread_t *ip = code;
+    size_t at;
+    uint32_t value;
+    int term;
+    unsigned char *to;
+    DISPATCH(0);
+
+    THREADED_HANDLERS(uint8_t, 8, 1)
+    THREADED_HANDLERS(uint16_t, 16, 1)
+    THREADED_HANDLERS(uint32_t, 32, 1)
+    THREADED_HANDLERS(uint8_t, 8g, 0)
+    THREADED_HANDLERS(uint16_t, 16g, 0)
+    THREADED_HANDLERS(uint32_t, 32g, 0)
+
+do_end:
+
+#undef DISPATCH
+#undef FIT
+
+    // Free the memory and the threaded code
+    if (guarded)
+        guarded_tape_unmap(&tape);
+    else
+        free(memory);
+    free(code);
+
+    return STATUS_OK;
+}
+
+// Growing buffer of machine code, for cells of `cell_size` bytes
+typedef struct {
+    unsigned char *code;
+    size_t size;
+    size_t max;
+    size_t cell_size;
+} jit_buffer_t;
+
+void jit_emit (jit_buffer_t *buffer, const void *bytes, size_t n)
+{
+    while (buffer->size + n > buffer->max){
+        buffer->max = buffer->max ? buffer->max * 2 : 4096;
+        buffer->code = realloc(buffer->code, buffer->max);
+    }
+    memcpy(buffer->code + buffer->size, bytes, n);
+    buffer->size += n;
+}
+
+void jit_emit_u8 (jit_buffer_t *buffer, uint8_t value)
+{
+    jit_emit(buffer, &value, 1);
+}
+
+void jit_emit_u32 (jit_buffer_t *buffer, uint32_t value)
+{
+    jit_emit(buffer, &value, 4); // x86-64 is little endian, as is the host
+}
+
+void jit_emit_u64 (jit_buffer_t *buffer, uint64_t value)
+{
+    jit_emit(buffer, &value, 8);
+}
+
+// Emits an immediate operand as wide as a cell
+void jit_emit_cell (jit_buffer_t *buffer, uint32_t value)
+{
+    jit_emit(buffer, &value, buffer->cell_size);
+}
+
+/* Emits the opcode of an instruction working on a cell: `byte_opcode` for
+   byte cells, otherwise `opcode`, with an operand size prefix for 16 bits */
+void jit_emit_cell_opcode (jit_buffer_t *buffer, uint8_t byte_opcode,
+                           uint8_t opcode)
+{
+    if (buffer->cell_size == 2)
+        jit_emit_u8(buffer, 0x66);
+    jit_emit_u8(buffer, buffer->cell_size == 1 ? byte_opcode : opcode);
+}
+
+// Emits the displacement of the cell `offset` from the current one
+void jit_emit_offset (jit_buffer_t *buffer, int offset)
+{
+    jit_emit_u32(buffer, offset * (int) buffer->cell_size);
+}
+
+// Points the rel32 at `at` (just before `at + 4`) to `target`
+void jit_patch_rel32 (jit_buffer_t *buffer, size_t at, size_t target)
+{
+    uint32_t rel = (uint32_t) (target - (at + 4));
+    memcpy(buffer->code + at, &rel, 4);
+}
+
+/* Register use in the generated code, all callee saved:
+   rbx - address of the current cell
+   r13 - output_t * handed to `jit_put` and `jit_get`
+   r12 - bf_slice_t * of the run, when it is run in slices
+   The code runs on a guarded tape, so nothing checks where rbx points. */
+
+// Called from the generated code for BF_PUT(_RUN) and BF_GET
+void jit_put (output_t *output, int value)
+{
+    output_put(output, value);
+}
+
+int jit_get (output_t *output, uint32_t current, int eof)
+{
+    return input_value(input_get(output), eof, current);
+}
+
+// Called from the generated code for BF_WRITE `op`, followed by its BF_TERMs
+void jit_write (output_t *output, const bf_op_t *op)
+{
+    unsigned char *to = output_reserve(output, op->arg);
+    for (int term = 1; term <= op->arg; term++)
+        to[term - 1] = op[term].arg;
+    output_commit(output, op->arg);
+}
+
+// Called from the generated code for BF_SCAN
+char *jit_scan_right (char *cell, size_t stride, size_t cell_size)
+{
+    char *start = active_tape->start;
+    size_t at = (cell - start) / cell_size;
+    size_t end = (active_tape->end - start) / cell_size;
+    return start + bf_scan_right(start, at, end, cell_size, stride) * cell_size;
+}
+
+char *jit_scan_left (char *cell, size_t stride, size_t cell_size)
+{
+    char *start = active_tape->start;
+    size_t at = (cell - start) / cell_size;
+    size_t found = bf_scan_left(start, at, cell_size, stride);
+    guarded_tape_scanned_left(at, found);
+    return start + found * cell_size;
+}
+
+// call `function` (mov rax, imm64; call rax)
+void jit_call (jit_buffer_t *buffer, void *function)
+{
+    jit_emit(buffer, "\x48\xb8", 2);
+    jit_emit_u64(buffer, (uint64_t) (uintptr_t) function);
+    jit_emit(buffer, "\xff\xd0", 2);
+}
+
+// Sets the flags for comparing the current cell to 0 (cmp [rbx], 0)
+void jit_test_cell (jit_buffer_t *buffer)
+{
+    jit_emit_cell_opcode(buffer, 0x80, 0x83);
+    jit_emit(buffer, "\x3b\x00", 2);
+}
+
+void jit_add (jit_buffer_t *buffer, int offset, int amount)
+{
+    // add [rbx + offset], amount
+    jit_emit_cell_opcode(buffer, 0x80, 0x81);
+    jit_emit_u8(buffer, 0x83);
+    jit_emit_offset(buffer, offset);
+    jit_emit_cell(buffer, amount);
+}
+
+void jit_move (jit_buffer_t *buffer, int amount)
+{
+    // add rbx, amount * cell_size
+    jit_emit(buffer, "\x48\x81\xc3", 3);
+    jit_emit_offset(buffer, amount);
+}
+
+void jit_set (jit_buffer_t *buffer, int offset, uint32_t value)
+{
+    // mov [rbx + offset], value
+    jit_emit_cell_opcode(buffer, 0xc6, 0xc7);
+    jit_emit_u8(buffer, 0x83);
+    jit_emit_offset(buffer, offset);
+    jit_emit_cell(buffer, value);
+}
+
+// Loads a cell zero extended into eax or esi (`modrm` 0x83 or 0xb3)
+void jit_load (jit_buffer_t *buffer, int offset, uint8_t modrm)
+{
+    // movzx reg, byte/word [rbx + offset] or mov reg, [rbx + offset]
+    if (buffer->cell_size == 4)
+        jit_emit_u8(buffer, 0x8b);
+    else
+        jit_emit(buffer, buffer->cell_size == 1 ? "\x0f\xb6" : "\x0f\xb7", 2);
+    jit_emit_u8(buffer, modrm);
+    jit_emit_offset(buffer, offset);
+}
+
+void jit_put_at (jit_buffer_t *buffer, int offset)
+{
+    // esi = cell; mov rdi, r13
+    jit_load(buffer, offset, 0xb3);
+    jit_emit(buffer, "\x4c\x89\xef", 3);
+    jit_call(buffer, (void *) jit_put);
+}
+
+void jit_get_at (jit_buffer_t *buffer, int offset, int eof)
+{
+    // esi = cell; mov edx, eof; mov rdi, r13
+    jit_load(buffer, offset, 0xb3);
+    jit_emit_u8(buffer, 0xba);
+    jit_emit_u32(buffer, eof);
+    jit_emit(buffer, "\x4c\x89\xef", 3);
+    jit_call(buffer, (void *) jit_get);
+    // mov [rbx + offset], al/ax/eax
+    jit_emit_cell_opcode(buffer, 0x88, 0x89);
+    jit_emit_u8(buffer, 0x83);
+    jit_emit_offset(buffer, offset);
+}
+
+// BF_MUL_ADD `op`, followed by its BF_TERMs
+void jit_mul_add (jit_buffer_t *buffer, const bf_op_t *op)
+{
+    // eax = cell; test eax, eax; jz past
+    jit_load(buffer, op->offset, 0x83);
+    jit_emit(buffer, "\x85\xc0\x0f\x84", 4);
+    jit_emit_u32(buffer, 0);
+    size_t skip = buffer->size - 4;
+
+    for (int term = 1; term <= op->arg; term++){
+        int to = op[term].offset;
+        int factor = op[term].arg;
+        if (factor == 1){
+            // add [rbx + to], al/ax/eax
+            jit_emit_cell_opcode(buffer, 0x00, 0x01);
+            jit_emit_u8(buffer, 0x83);
+        } else {
+            // imul edx, eax, factor; add [rbx + to], dl/dx/edx
+            jit_emit(buffer, "\x69\xd0", 2);
+            jit_emit_u32(buffer, factor);
+            jit_emit_cell_opcode(buffer, 0x00, 0x01);
+            jit_emit_u8(buffer, 0x93);
+        }
+        jit_emit_offset(buffer, to);
+    }
+    jit_set(buffer, op->offset, 0);
+
+    jit_patch_rel32(buffer, skip, buffer->size);
+}
+
+void jit_scan (jit_buffer_t *buffer, int amount)
+{
+    // mov rdi, rbx; mov esi, |amount|; mov edx, cell_size
+    jit_emit(buffer, "\x48\x89\xdf\xbe", 4);
+    jit_emit_u32(buffer, amount > 0 ? amount : -amount);
+    jit_emit_u8(buffer, 0xba);
+    jit_emit_u32(buffer, buffer->cell_size);
+    jit_call(buffer, amount > 0 ? (void *) jit_scan_right : (void *) jit_scan_left);
+    // mov rbx, rax
+    jit_emit(buffer, "\x48\x89\xc3", 3);
+}
+
+/* Translates instruction space to x86-64 machine code with the signature
+   int (void *tape, output_t *output), which returns STATUS_OK. Loop
+   constructs are resolved through the destinations `bf_data_from_source`
+   stored, using `native` to map an instruction's index to its offset in
+   the machine code.
+
+   When `sliced` the signature is int (void *cell, output_t *output,
+   bf_slice_t *slice, void *entry) instead, starting at the instruction at
+   `entry` and returning STATUS_SUSPENDED like `bf_data_run_slice` does,
+   and `native` is returned to find entries with. Otherwise NULL is. */
+size_t *jit_compile (bf_data_t *bf_data, jit_buffer_t *buffer, int sliced)
+{
+    const bf_op_t *ops = bf_data->ops;
+    size_t *native = calloc(bf_data->length + 1, sizeof(size_t));
+
+    // push rbx; push r13; push rax or r12 (keeps the stack 16 byte aligned)
+    // mov rbx, rdi; mov r13, rsi
+    jit_emit(buffer, "\x53\x41\x55", 3);
+    jit_emit(buffer, sliced ? "\x41\x54" : "\x50", sliced ? 2 : 1);
+    jit_emit(buffer, "\x48\x89\xfb\x49\x89\xf5", 6);
+    // mov r12, rdx; jmp rcx
+    if (sliced)
+        jit_emit(buffer, "\x49\x89\xd4\xff\xe1", 5);
+
+    size_t i;
+    for (i = 0; ops[i].op != BF_END; i += bf_op_length(ops + i)){
+        native[i] = buffer->size;
+
+        const bf_op_t *op = ops + i;
+        switch(op->op){
+        case BF_ADD:
+            jit_add(buffer, op->offset, op->arg);
+            break;
+        case BF_MOVE:
+            jit_move(buffer, op->arg);
+            break;
+        case BF_GET:
+            jit_get_at(buffer, op->offset, bf_data->eof);
+            break;
+        case BF_PUT:
+            jit_put_at(buffer, op->offset);
+            break;
+        case BF_CLEAR:
+            jit_set(buffer, op->offset, 0);
+            break;
+        case BF_SET:
+            jit_set(buffer, op->offset, op->arg);
+            break;
+        case BF_WRITE:
+            // mov rdi, r13; mov rsi, op
+            jit_emit(buffer, "\x4c\x89\xef\x48\xbe", 5);
+            jit_emit_u64(buffer, (uint64_t) (uintptr_t) op);
+            jit_call(buffer, (void *) jit_write);
+            break;
+        case BF_SCAN:
+            jit_scan(buffer, op->arg);
+            break;
+        case BF_MUL_ADD:
+            jit_mul_add(buffer, op);
+            break;
+        case BF_PUT_RUN:
+            for (int term = 1; term <= op->arg; term++)
+                jit_put_at(buffer, op[term].offset);
+            break;
+        case BF_LOOP_START:
+            // cmp [rbx], 0; je past matching BF_LOOP_END (patched there)
+            jit_test_cell(buffer);
+            jit_emit(buffer, "\x0f\x84", 2);
+            jit_emit_u32(buffer, 0);
+            break;
+        case BF_LOOP_END: {
+            // cmp [rbx], 0; jne to the start of the body, which is where
+            // the instruction after the BF_LOOP_START starts
+            size_t body = native[op->arg + 1];
+            jit_test_cell(buffer);
+            if (sliced){
+                // je past; sub qword [r12 + budget], 1; jns to the body
+                jit_emit(buffer, "\x0f\x84", 2);
+                jit_emit_u32(buffer, 0);
+                size_t past = buffer->size - 4;
+                jit_emit(buffer, "\x49\x83\x6c\x24", 4);
+                jit_emit_u8(buffer, offsetof(bf_slice_t, budget));
+                jit_emit(buffer, "\x01\x0f\x89", 3);
+                jit_emit_u32(buffer, 0);
+                jit_patch_rel32(buffer, buffer->size - 4, body);
+                // Out of budget, stop before going back:
+                // mov qword [r12 + insptr], i;
+                // mov [r12 + cell], rbx; mov eax, STATUS_SUSPENDED
+                jit_emit(buffer, "\x49\xc7\x44\x24", 4);
+                jit_emit_u8(buffer, offsetof(bf_slice_t, insptr));
+                jit_emit_u32(buffer, i);
+                jit_emit(buffer, "\x49\x89\x5c\x24", 4);
+                jit_emit_u8(buffer, offsetof(bf_slice_t, cell));
+                jit_emit_u8(buffer, 0xb8);
+                jit_emit_u32(buffer, STATUS_SUSPENDED);
+                // pop r12; pop r13; pop rbx; ret
+                jit_emit(buffer, "\x41\x5c\x41\x5d\x5b\xc3", 6);
+                jit_patch_rel32(buffer, past, buffer->size);
+            } else {
+                jit_emit(buffer, "\x0f\x85", 2);
+                jit_emit_u32(buffer, 0);
+                jit_patch_rel32(buffer, buffer->size - 4, body);
+            }
+            jit_patch_rel32(buffer, body - 4, buffer->size);
+            break;
+        }
+        }
+    }
+    native[i] = buffer->size;
+
+    // xor eax, eax; pop rcx or r12; pop r13; pop rbx; ret
+    jit_emit(buffer, "\x31\xc0", 2);
+    jit_emit(buffer, sliced ? "\x41\x5c" : "\x59", sliced ? 2 : 1);
+    jit_emit(buffer, "\x41\x5d\x5b\xc3", 4);
+
+    if (sliced)
+        return native;
+    free(native);
+    return NULL;
+}
+
+/* Copies the code in `buffer` to memory that is executable, but no longer
+   writable, and frees the buffer. Returns NULL on failure. */
+void *jit_map (jit_buffer_t *buffer)
+{
+    void *code = mmap(NULL, buffer->size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (code == MAP_FAILED){
+        free(buffer->code);
+        return NULL;
+    }
+    memcpy(code, buffer->code, buffer->size);
+    free(buffer->code);
+    if (mprotect(code, buffer->size, PROT_READ | PROT_EXEC) != 0){
+        munmap(code, buffer->size);
+        return NULL;
+    }
+    return code;
+}
+
+// Compiles the program in a bf_data_t to machine code and runs it
+int bf_data_run_jit (bf_data_t *bf_data, output_t *output)
+{
+#if defined(__x86_64__)
+    jit_buffer_t buffer = {NULL, 0, 0, bf_data->cell_size};
+    jit_compile(bf_data, &buffer, 0);
+    void *code = jit_map(&buffer);
+    if (code == NULL)
+        return STATUS_CANNOT_MAP_MEMORY;
+
+    guarded_tape_t tape;
+    if (guarded_tape_map(&tape) != STATUS_OK){
+        munmap(code, buffer.size);
+        return STATUS_CANNOT_MAP_MEMORY;
+    }
+
+    int (*program)(void *, output_t *) = (int (*)(void *, output_t *)) code;
+    int status = program(tape.start, output);
+
+    guarded_tape_unmap(&tape);
+    munmap(code, buffer.size);
+
+    return status;
+#else
+    return STATUS_JIT_UNSUPPORTED;
+#endif
+}
+
+/* Runs the program in a bf_data_t like `bf_data_run_slice` does, compiled
+   to machine code when the run starts, which the slice keeps until it
+   ends. The back edges are counted in the machine code itself. */
+int bf_data_run_jit_slice (bf_data_t *bf_data, output_t *output,
+                           bf_slice_t *slice)
+{
+#if defined(__x86_64__)
+    size_t cell_size = bf_data->cell_size;
+    // A run the interpreter started on a guarded tape is compiled here too
+    if (slice->code == NULL){
+        jit_buffer_t buffer = {NULL, 0, 0, cell_size};
+        slice->native = jit_compile(bf_data, &buffer, 1);
+        slice->code_size = buffer.size;
+        slice->code = jit_map(&buffer);
+        if (slice->code == NULL){
+            bf_slice_drop(slice);
+            return STATUS_CANNOT_MAP_MEMORY;
+        }
+    }
+    if (slice->memory == NULL){
+        slice->tape_mode = TAPE_GUARDED;
+        slice->insptr = 0;
+        slice->memptr = 0;
+        if (guarded_tape_map(&slice->tape) != STATUS_OK){
+            bf_slice_drop(slice);
+            return STATUS_CANNOT_MAP_MEMORY;
+        }
+        slice->memory = slice->tape.start;
+    } else
+        active_tape = &slice->tape;
+
+    int (*program)(void *, output_t *, bf_slice_t *, void *)
+        = (int (*)(void *, output_t *, bf_slice_t *, void *)) slice->code;
+    int status = program(slice->tape.start + slice->memptr * cell_size, output,
+                         slice, (char *) slice->code + slice->native[slice->insptr]);
+
+    if (status == STATUS_SUSPENDED){
+        slice->budget = 0;
+        slice->memptr = (slice->cell - slice->tape.start) / cell_size;
+        active_tape = NULL;
+    } else
+        bf_slice_drop(slice);
+    return status;
+#else
+    return STATUS_JIT_UNSUPPORTED;
+#endif
+}
+
+/* Runs the program in a bf_data_t on the switch interpreter, or compiled
+   to machine code if `jit`, with the budget of `slice` as a quota: a run
+   that goes past it stops with STATUS_OVER_QUOTA. Once it is done,
+   `bf_slice_drop` gives back whatever the run kept. */
+int bf_data_run_quota (bf_data_t *bf_data, output_t *output, int jit,
+                       bf_slice_t *slice)
+{
+    int status = jit ? bf_data_run_jit_slice(bf_data, output, slice)
+                     : bf_data_run_slice(bf_data, output, slice);
+    return status == STATUS_SUSPENDED ? STATUS_OVER_QUOTA : status;
+}
+
+// Back edges a tiered run takes on the interpreter before it is compiled
+#define TIERED_BACK_EDGES ((long) 1 << 16)
+
+/* Runs the program in a bf_data_t on the switch interpreter, on a guarded
+   tape, until it went back to the start of its loops TIERED_BACK_EDGES
+   times. Programs that run that long are compiled to machine code then,
+   which takes over the tape and goes on at the BF_LOOP_END the run
+   stopped at, in the loop running most likely. Short runs never wait for
+   the compiler that way, long ones only run their start interpreted.
+   Like `bf_data_run_quota`, the run is kept in `slice`. */
+int bf_data_run_tiered (bf_data_t *bf_data, output_t *output, bf_slice_t *slice)
+{
+    bf_data_t guarded = *bf_data;
+    guarded.tape_mode = TAPE_GUARDED;
+    slice->budget = TIERED_BACK_EDGES;
+    int status = bf_data_run_slice(&guarded, output, slice);
+    if (status != STATUS_SUSPENDED)
+        return status;
+
+    slice->budget = LONG_MAX;
+    status = bf_data_run_jit_slice(&guarded, output, slice);
+    if (status == STATUS_JIT_UNSUPPORTED)
+        status = bf_data_run_slice(&guarded, output, slice);
+    return status;
+}
+
+
+/* Starts a command, with its standard input coming from a pipe whose
+   writing end is put in `input` unless that is NULL. Returns its pid, or
+   -1 if it could not be started. */
+pid_t command_start (char *const argv[], int *input)
+{
+    int pipe_fds[2];
+    if (input != NULL && pipe(pipe_fds) == -1)
+        return -1;
+
+    pid_t pid = fork();
+    if (pid == 0){
+        if (input != NULL){
+            dup2(pipe_fds[0], STDIN_FILENO);
+            close(pipe_fds[0]);
+            close(pipe_fds[1]);
+        }
+        execvp(argv[0], argv);
+        perror(argv[0]);
+        _exit(EX_UNAVAILABLE);
+    }
+
+    if (input != NULL){
+        close(pipe_fds[0]);
+        if (pid == -1)
+            close(pipe_fds[1]);
+        else
+            *input = pipe_fds[1];
+    }
+    return pid;
+}
+
+// Waits for a command to exit, STATUS_COMMAND_FAILED unless it succeeds
+int command_wait (pid_t pid, const char *name)
+{
+    int wstatus;
+    while (waitpid(pid, &wstatus, 0) == -1)
+        if (errno != EINTR)
+            return STATUS_COMMAND_FAILED;
+
+    if (WIFSIGNALED(wstatus)){
+        fprintf(stderr, "%s was killed by signal %d\n", name, WTERMSIG(wstatus));
+        return STATUS_COMMAND_FAILED;
+    }
+    if (!WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != 0){
+        fprintf(stderr, "%s did not finish successfully (exit status %d)\n",
+                name, WIFEXITED(wstatus) ? WEXITSTATUS(wstatus) : -1);
+        return STATUS_COMMAND_FAILED;
+    }
+    return STATUS_OK;
+}
+
+// Runs a command until it exits, STATUS_COMMAND_FAILED unless it succeeds
+int run_command (char *const argv[])
+{
+    pid_t pid = command_start(argv, NULL);
+    if (pid == -1)
+        return STATUS_COMMAND_FAILED;
+    return command_wait(pid, argv[0]);
+}
+
+// Times GCC unrolls the loops a profile found hot
+#define PROFILE_UNROLL 4
+
+// Whether all the program does is write output `constants` worked out
+int bf_data_precomputed (const bf_data_t *bf_data)
+{
+    const bf_op_t *ops = bf_data->ops;
+    for (size_t i = 0; ops[i].op != BF_END; i += bf_op_length(ops + i))
+        if (ops[i].op != BF_WRITE)
+            return 0;
+    return 1;
+}
+
+/* Writes C for a program that is `bf_data_precomputed`: its output as
+   one array, written with a single write(2) unless that is cut short */
+void gcc_precomputed (bf_data_t *bf_data, FILE *intermediate)
+{
+    const bf_op_t *ops = bf_data->ops;
+    size_t length = 0;
+
+    fprintf(intermediate,
+            "#include <errno.h>\n"
+            "#include <unistd.h>\n"
+            "static const unsigned char out[]={");
+    for (size_t i = 0; ops[i].op != BF_END; i += bf_op_length(ops + i)){
+        for (int term = 1; term <= ops[i].arg; term++)
+            fprintf(intermediate, "%u,", (unsigned char) ops[i + term].arg);
+        fprintf(intermediate, "\n");
+        length += ops[i].arg;
+    }
+    fprintf(intermediate,
+            "0};"
+            "int main(void){"
+            "    size_t done=0;"
+            "    while(done<%zu){"
+            "        ssize_t n=write(1,out+done,%zu-done);"
+            "        if(n==-1&&errno==EINTR) continue;"
+            "        if(n<=0) return 1;"
+            "        done+=n;"
+            "    }"
+            "    return 0;"
+            "}\n", length, length);
+}
+
+// The -O level that favours small code over fast code
+#define OPT_SIZE 4
+
+// Writes the -O flag for `opt_level` into `flag`, -Os for OPT_SIZE
+void opt_flag (char flag[4], int opt_level)
+{
+    flag[0] = '-';
+    flag[1] = 'O';
+    flag[2] = opt_level == OPT_SIZE ? 's' : '0' + opt_level;
+    flag[3] = '\0';
+}
+
+// Size in bytes of the tape of GCC and LLVM compiled programs
+#define COMPILED_TAPE_SIZE ((size_t) 1 << 30)
+
+/* Compiles the program contained in a bf_data_t with GCC at `opt_level`,
+   for the CPU of this machine if `native` is set. The C is written
+   straight into `gcc -x c -` through a pipe.
+
+   The tape is allocated once at its full size and main walks it with a
+   local restrict pointer, so GCC keeps that in a register and can
+   vectorize the straight-line arithmetic of blocks and multiply loops.
+   Bounds are checked once per block against the end of the tape. */
+int bf_data_through_gcc (bf_data_t *bf_data, char *output_filename,
+                         int opt_level, int native)
+{
+    char level[4];
+    opt_flag(level, opt_level);
+    char *gcc[] = {"gcc", "-x", "c", level, "-", "-o", output_filename,
+                   native ? "-march=native" : NULL, NULL};
+
+    int intermediate_fd;
+    pid_t pid = command_start(gcc, &intermediate_fd);
+    if (pid == -1)
+        return STATUS_CANNOT_REACH_GCC;
+
+    FILE *intermediate = fdopen(intermediate_fd, "w");
+
+    /* If GCC gives up early, writes fail with EPIPE instead of killing
+       us, and its exit status says what went wrong */
+    struct sigaction ignore = {.sa_handler = SIG_IGN}, previous;
+    sigaction(SIGPIPE, &ignore, &previous);
+
+    if (intermediate != NULL && bf_data_precomputed(bf_data)){
+        gcc_precomputed(bf_data, intermediate);
+        fclose(intermediate);
+    } else if(intermediate != NULL) {
+
+        // Write to GCC
+        
+        int insptr;
+        int size = opt_level == OPT_SIZE;
+        size_t cells = bf_data->tape_cells ? bf_data->tape_cells
+            : COMPILED_TAPE_SIZE / bf_data->cell_size;
+
+        fprintf(intermediate,
+                // Includes
+                "#define _GNU_SOURCE\n"
+                "#include <stdlib.h>\n"
+                "#include <stdio.h>\n"
+                "#include <stdint.h>\n"
+                "#include <string.h>\n"
+                "#include <errno.h>\n"
+                "#include <unistd.h>\n"
+
+                // Cells wrap around at the chosen width
+                "typedef uint%zu_t cell;"
+                "enum{CELLS=%zu};\n"
+
+                // Helpers are inlined for speed, called once each for size
+                "#define HELPER static %s\n"
+
+                // Output is buffered like `output_t` does it
+                "static unsigned char out_buffer[%zu];"
+                "static size_t out_used;"
+                "static int out_line;"
+                "static void out_flush(void){"
+                "    size_t done=0;"
+                "    while(done<out_used){"
+                "        ssize_t n=write(1,out_buffer+done,out_used-done);"
+                "        if(n==-1&&errno==EINTR) continue;"
+                "        if(n<=0) break;"
+                "        done+=n;"
+                "    }"
+                "    out_used=0;"
+                "}"
+                "HELPER void out_put(int c){"
+                "    out_buffer[out_used++]=c;"
+                "    if(out_used==sizeof(out_buffer)||(out_line&&c=='\\n'))"
+                "        out_flush();"
+                "}"
+                // Input is read in blocks, and stored as `eof` says at the end
+                "static unsigned char in_buffer[%zu];"
+                "static size_t in_used, in_length;"
+                "HELPER void in_get(cell *to){"
+                "    if(out_line) out_flush();"
+                "    if(in_used==in_length){"
+                "        ssize_t n;"
+                "        do n=read(0,in_buffer,sizeof(in_buffer));"
+                "        while(n==-1&&errno==EINTR);"
+                "        if(n<=0){%s return;}"
+                "        in_used=0;in_length=n;"
+                "    }"
+                "    *to=in_buffer[in_used++];"
+                "}"
+
+                // Leaving the tape ends the program like the LLVM one does
+                "__attribute__((cold,noreturn)) static void off_tape(const char *m){"
+                "    out_flush();"
+                "    fputs(m,stderr);"
+                "    exit(%d);"
+                "}\n"
+                "#define out_of_tape() "
+                "off_tape(\"Memory pointer moved past the end of the tape\\n\")\n"
+                "#define before_tape() "
+                "off_tape(\"Memory pointer moved before the start of the tape\\n\")\n"
+                "#define FITS(p,reach) "
+                "if(__builtin_expect((size_t)((p)-tape)+(reach)>=CELLS,0)) out_of_tape()\n"
+                "#define FITS_LOW(p,lowest) "
+                "if(__builtin_expect((p)-tape+(lowest)<0,0)) before_tape()\n"
+
+                // Open main
+                "int main(void) {"
+                "    out_line = %d || isatty(1);"
+                "    cell *const tape = calloc(CELLS,sizeof(cell));"
+                "    if(tape==NULL) return 1;"
+                "    cell *restrict p = tape;\n",
+                bf_data->cell_size * 8, cells,
+                size ? "__attribute__((noinline))" : "inline",
+                OUTPUT_BUFFER_SIZE, OUTPUT_BUFFER_SIZE,
+                bf_data->eof == EOF_UNCHANGED ? ""
+                : bf_data->eof == EOF_ZERO ? "*to=0;" : "*to=(cell)-1;",
+                EX_SOFTWARE, bf_data->line_buffered);
+
+        // Instructions up to here are known to fit on the tape
+        int checked_until = 0;
+
+        // Generate the actual instructions
+        const bf_op_t *ops = bf_data->ops;
+        for (insptr = 0;
+             ops[insptr].op != BF_END;
+             insptr += bf_op_length(ops + insptr)) {
+            // Check a whole lowered basic block at once, unless it is
+            // known to be on the tape already
+            if (insptr >= checked_until
+                && !(ops[insptr].flags & BF_FLAG_BOUNDED)){
+                int lowest;
+                int reach = block_reach(ops, insptr, &checked_until, &lowest);
+                if (reach > 0)
+                    fprintf(intermediate,"FITS(p,%i);\n", reach);
+                if (lowest < 0)
+                    fprintf(intermediate,"FITS_LOW(p,%i);\n", lowest);
+            }
+
+            const bf_op_t *op = ops + insptr;
+            switch (op->op) {
+            case BF_ADD:
+                fprintf(intermediate,"p[%i] += %i;\n", op->offset, op->arg);
+                break;
+            case BF_MOVE:
+                fprintf(intermediate,"p += %i;\n", op->arg);
+                break;
+            case BF_GET:
+                fprintf(intermediate,"in_get(p+%i);\n", op->offset);
+                break;
+            case BF_PUT:
+                fprintf(intermediate,"out_put(p[%i]);\n", op->offset);
+                break;
+            case BF_CLEAR:
+                fprintf(intermediate,"p[%i] = 0;\n", op->offset);
+                break;
+            case BF_SET:
+                fprintf(intermediate,"p[%i] = %u;\n",
+                        op->offset, (unsigned) op->arg);
+                break;
+            case BF_WRITE:
+                for (int term = 1; term <= op->arg; term++)
+                    fprintf(intermediate,"out_put(%i);", op[term].arg);
+                fprintf(intermediate,"\n");
+                break;
+            case BF_SCAN:
+                // Byte cells one apart are searched for with the C library
+                if (bf_data->cell_size == 1 && op->arg == 1)
+                    fprintf(intermediate,"p = memchr(p,0,tape+CELLS-p);"
+                            "if(p==NULL) out_of_tape();\n");
+                else if (bf_data->cell_size == 1 && op->arg == -1)
+                    fprintf(intermediate,"p = memrchr(tape,0,p-tape+1);"
+                            "if(p==NULL) before_tape();\n");
+                else if (op->arg > 0)
+                    fprintf(intermediate,"while(*p!=0){p += %i;FITS(p,0);}\n",
+                            op->arg);
+                else
+                    // Checked before each step, so p never points before tape
+                    fprintf(intermediate,"while(*p!=0){FITS_LOW(p,%i);p += %i;}\n",
+                            op->arg, op->arg);
+                break;
+            case BF_MUL_ADD: {
+                /* Terms known to be on the tape are added without a branch,
+                   which adds nothing when the counter is zero. Others are
+                   only touched once the tape is checked to reach them. */
+                int bounded = (op->flags & BF_FLAG_BOUNDED) != 0;
+                int reach = op->offset;
+                int lowest = 0;
+                int term;
+                for (term = 1; term <= op->arg; term++){
+                    if (op[term].offset > reach)
+                        reach = op[term].offset;
+                    if (op[term].offset < lowest)
+                        lowest = op[term].offset;
+                }
+
+                fprintf(intermediate,"{cell v=p[%i];", op->offset);
+                if (!bounded)
+                    fprintf(intermediate,"if(v!=0){FITS(p,%i);", reach);
+                if (!bounded && lowest < 0)
+                    fprintf(intermediate,"FITS_LOW(p,%i);", lowest);
+                for (term = 1; term <= op->arg; term++)
+                    fprintf(intermediate,"p[%i] += (cell)(v*%i);",
+                            op[term].offset, op[term].arg);
+                fprintf(intermediate,"p[%i] = 0;}%s\n", op->offset,
+                        bounded ? "" : "}");
+                break;
+            }
+            case BF_PUT_RUN:
+                for (int term = 1; term <= op->arg; term++)
+                    fprintf(intermediate,"out_put(p[%i]);", op[term].offset);
+                fprintf(intermediate,"\n");
+                break;
+            case BF_LOOP_START:
+                /* Loops a profile found hot are unrolled unless optimizing
+                   for size, cold ones kept out of the way */
+                if (op->flags & BF_FLAG_HOT){
+                    if (!size)
+                        fprintf(intermediate,"#pragma GCC unroll %d\n",
+                                PROFILE_UNROLL);
+                    fprintf(intermediate,"while(__builtin_expect(*p!=0,1)){\n");
+                } else if (op->flags & BF_FLAG_COLD)
+                    fprintf(intermediate,"while(__builtin_expect(*p!=0,0)){\n");
+                else
+                    fprintf(intermediate,"while(*p!=0){\n");
+                break;
+            case BF_LOOP_END:
+                fprintf(intermediate,"}\n");
+                break;
+            case BF_FIT:
+                fprintf(intermediate,"FITS(p,%i);\n", op->arg);
+                break;
+            }
+        }
+
+        // Now write out what is left and close main
+        fprintf(intermediate,"out_flush();}\n");
+        
+        // Closing the pipe lets gcc finish
+        fclose(intermediate);
+    } else
+        close(intermediate_fd);
+
+    sigaction(SIGPIPE, &previous, NULL);
+    return command_wait(pid, "gcc");
+}
+
+// Whether `filename` ends in `suffix`
+int has_suffix (const char *filename, const char *suffix)
+{
+    size_t length = strlen(filename);
+    size_t suffix_length = strlen(suffix);
+    return length >= suffix_length
+        && strcmp(filename + length - suffix_length, suffix) == 0;
+}
+
+/* State while writing LLVM IR, `next` numbers the unnamed values and
+   `cell` is the integer type of a cell */
+typedef struct {
+    FILE *out;
+    int next;
+    const char *cell;
+    size_t cell_size;
+    size_t cells; // Number of cells on the tape
+    int eof;      // Of the bf_data_t
+} llvm_emitter_t;
+
+// Emits the address of the cell `offset` from the memory pointer
+int llvm_cell (llvm_emitter_t *emitter, int offset)
+{
+    int n = emitter->next;
+    emitter->next += 3;
+    fprintf(emitter->out,
+            "  %%t%i = load i64, i64* %%p\n"
+            "  %%t%i = add i64 %%t%i, %i\n"
+            "  %%t%i = getelementptr %s, %s* %%tape, i64 %%t%i\n",
+            n, n + 1, n, offset, n + 2, emitter->cell, emitter->cell, n + 1);
+    return n + 2;
+}
+
+// Emits a load of the cell `offset` from the memory pointer
+int llvm_load (llvm_emitter_t *emitter, int offset)
+{
+    int cell = llvm_cell(emitter, offset);
+    int n = emitter->next++;
+    fprintf(emitter->out, "  %%t%i = load %s, %s* %%t%i\n",
+            n, emitter->cell, emitter->cell, cell);
+    return n;
+}
+
+// Branches to %out_of_tape unless the cell `reach` further is on the tape
+void llvm_check_reach (llvm_emitter_t *emitter, int reach)
+{
+    int n = emitter->next;
+    emitter->next += 3;
+    fprintf(emitter->out,
+            "  %%t%i = load i64, i64* %%p\n"
+            "  %%t%i = add i64 %%t%i, %i\n"
+            "  %%t%i = icmp ult i64 %%t%i, %zu\n"
+            "  br i1 %%t%i, label %%ok%i, label %%out_of_tape\n"
+            "ok%i:\n",
+            n, n + 1, n, reach, n + 2, n + 1, emitter->cells, n + 2, n, n);
+}
+
+// Branches to %before_tape unless the cell `lowest` (0 or less) away is on the tape
+void llvm_check_lowest (llvm_emitter_t *emitter, int lowest)
+{
+    int n = emitter->next;
+    emitter->next += 3;
+    fprintf(emitter->out,
+            "  %%t%i = load i64, i64* %%p\n"
+            "  %%t%i = add i64 %%t%i, %i\n"
+            "  %%t%i = icmp slt i64 %%t%i, 0\n"
+            "  br i1 %%t%i, label %%before_tape, label %%ok%i\n"
+            "ok%i:\n",
+            n, n + 1, n, lowest, n + 2, n + 1, n + 2, n, n);
+}
+
+void llvm_add (llvm_emitter_t *emitter, int offset, int amount)
+{
+    int cell = llvm_cell(emitter, offset);
+    int n = emitter->next;
+    emitter->next += 2;
+    const char *type = emitter->cell;
+    fprintf(emitter->out,
+            "  %%t%i = load %s, %s* %%t%i\n"
+            "  %%t%i = add %s %%t%i, %i\n"
+            "  store %s %%t%i, %s* %%t%i\n",
+            n, type, type, cell, n + 1, type, n, amount,
+            type, n + 1, type, cell);
+}
+
+void llvm_move (llvm_emitter_t *emitter, int amount)
+{
+    int n = emitter->next;
+    emitter->next += 2;
+    fprintf(emitter->out,
+            "  %%t%i = load i64, i64* %%p\n"
+            "  %%t%i = add i64 %%t%i, %i\n"
+            "  store i64 %%t%i, i64* %%p\n",
+            n, n + 1, n, amount, n + 1);
+}
+
+void llvm_set (llvm_emitter_t *emitter, int offset, uint32_t value)
+{
+    // As a signed constant, which is how LLVM takes them
+    long long constant = emitter->cell_size == 1 ? (int8_t) value
+                       : emitter->cell_size == 2 ? (int16_t) value
+                       : (int32_t) value;
+    int cell = llvm_cell(emitter, offset);
+    fprintf(emitter->out, "  store %s %lld, %s* %%t%i\n",
+            emitter->cell, constant, emitter->cell, cell);
+}
+
+void llvm_put (llvm_emitter_t *emitter, int offset)
+{
+    int value = llvm_load(emitter, offset);
+    int n = emitter->next++;
+    fprintf(emitter->out,
+            "  %%t%i = %s %s %%t%i to i8\n"
+            "  call void @out_put(i8 %%t%i)\n",
+            n, emitter->cell_size > 1 ? "trunc" : "bitcast",
+            emitter->cell, value, n);
+}
+
+void llvm_get (llvm_emitter_t *emitter, int offset)
+{
+    int n = emitter->next;
+    emitter->next += 2;
+    fprintf(emitter->out,
+            "  %%t%i = call i32 @in_get()\n"
+            "  %%t%i = %s i32 %%t%i to %s\n",
+            n, n + 1, emitter->cell_size < 4 ? "trunc" : "bitcast",
+            n, emitter->cell);
+    int value = n + 1;
+
+    // At the end of input in_get gives -1, which other settings replace
+    if (emitter->eof != EOF_MINUS_ONE){
+        char instead[16] = "0";
+        if (emitter->eof == EOF_UNCHANGED)
+            snprintf(instead, sizeof(instead), "%%t%i",
+                     llvm_load(emitter, offset));
+        value = emitter->next;
+        emitter->next += 2;
+        fprintf(emitter->out,
+                "  %%t%i = icmp slt i32 %%t%i, 0\n"
+                "  %%t%i = select i1 %%t%i, %s %s, %s %%t%i\n",
+                value, n, value + 1, value, emitter->cell, instead,
+                emitter->cell, n + 1);
+        value++;
+    }
+
+    int cell = llvm_cell(emitter, offset);
+    fprintf(emitter->out, "  store %s %%t%i, %s* %%t%i\n",
+            emitter->cell, value, emitter->cell, cell);
+}
+
+/* BF_MUL_ADD `op`, followed by its BF_TERMs. Its terms to the left are
+   left out of the check of its block, and checked once the counter is not
+   0 unless the program is known to stay on the tape. */
+void llvm_mul_add (llvm_emitter_t *emitter, const bf_op_t *op)
+{
+    int value = llvm_load(emitter, op->offset);
+    int n = emitter->next++;
+    fprintf(emitter->out,
+            "  %%t%i = icmp eq %s %%t%i, 0\n"
+            "  br i1 %%t%i, label %%mul_done%i, label %%mul%i\n"
+            "mul%i:\n",
+            n, emitter->cell, value, n, n, n, n);
+    int lowest = 0;
+    for (int term = 1; term <= op->arg; term++)
+        if (op[term].offset < lowest)
+            lowest = op[term].offset;
+    if (lowest < 0 && !(op->flags & BF_FLAG_BOUNDED))
+        llvm_check_lowest(emitter, lowest);
+    for (int term = 1; term <= op->arg; term++){
+        int cell = llvm_cell(emitter, op[term].offset);
+        int m = emitter->next;
+        emitter->next += 3;
+        const char *type = emitter->cell;
+        fprintf(emitter->out,
+                "  %%t%i = load %s, %s* %%t%i\n"
+                "  %%t%i = mul %s %%t%i, %i\n"
+                "  %%t%i = add %s %%t%i, %%t%i\n"
+                "  store %s %%t%i, %s* %%t%i\n",
+                m, type, type, cell, m + 1, type, value, op[term].arg,
+                m + 2, type, m, m + 1, type, m + 2, type, cell);
+    }
+    llvm_set(emitter, op->offset, 0);
+    fprintf(emitter->out, "  br label %%mul_done%i\nmul_done%i:\n", n, n);
+}
+
+void llvm_scan (llvm_emitter_t *emitter, int amount)
+{
+    int n = emitter->next++;
+    fprintf(emitter->out, "  br label %%scan%i\nscan%i:\n", n, n);
+    int value = llvm_load(emitter, 0);
+    int zero = emitter->next++;
+    fprintf(emitter->out,
+            "  %%t%i = icmp eq %s %%t%i, 0\n"
+            "  br i1 %%t%i, label %%scan_done%i, label %%scan_step%i\n"
+            "scan_step%i:\n",
+            zero, emitter->cell, value, zero, n, n, n);
+    llvm_move(emitter, amount);
+    if (amount > 0)
+        llvm_check_reach(emitter, 0);
+    else
+        llvm_check_lowest(emitter, 0);
+    fprintf(emitter->out, "  br label %%scan%i\nscan_done%i:\n", n, n);
+}
+
+/* Weight of the likely side of the branches of loops marked by a profile,
+   against 1 for the other side */
+#define LLVM_LIKELY_WEIGHT 2000
+
+/* Attachment for a branch of the loop starting at `start`, the one at its
+   start if `into` is 0 (its body is the second label) or the one at its
+   end going back into it otherwise (its body is the first label) */
+const char *llvm_weights (const bf_op_t *start, int into)
+{
+    int likely = start->flags & BF_FLAG_HOT;
+    if (!likely && !(start->flags & BF_FLAG_COLD))
+        return "";
+    // !0 makes the first label likely, !1 the second
+    return likely == into ? ", !prof !0" : ", !prof !1";
+}
+
+// Writes the program contained in a bf_data_t as an LLVM IR module
+void llvm_emit_module (bf_data_t *bf_data, FILE *out)
+{
+    const bf_op_t *ops = bf_data->ops;
+    static const char *cell_types[] = {"", "i8", "i16", "", "i32"};
+    llvm_emitter_t emitter = {out, 0, cell_types[bf_data->cell_size],
+                              bf_data->cell_size,
+                              COMPILED_TAPE_SIZE / bf_data->cell_size, bf_data->eof};
+    static const char out_of_tape[] =
+        "Memory pointer moved past the end of the tape\\0A";
+    static const char before_tape[] =
+        "Memory pointer moved before the start of the tape\\0A";
+
+    fprintf(out,
+            "declare i8* @calloc(i64, i64)\n"
+            "declare i64 @read(i32, i8*, i64)\n"
+            "declare i64 @write(i32, i8*, i64)\n"
+            "declare i32 @isatty(i32)\n"
+            "declare void @exit(i32) noreturn\n"
+            "@out_of_tape = private constant [%zu x i8] c\"%s\"\n"
+            "@before_tape = private constant [%zu x i8] c\"%s\"\n",
+            sizeof(out_of_tape) - 3, out_of_tape,
+            sizeof(before_tape) - 3, before_tape);
+
+    // Output is buffered like `output_t` does it, dropped if it cannot go
+    fprintf(out,
+            "@out_buffer = internal global [%zu x i8] zeroinitializer\n"
+            "@out_used = internal global i64 0\n"
+            "@out_line = internal global i1 false\n"
+            "define internal void @out_flush() {\n"
+            "entry:\n"
+            "  %%used = load i64, i64* @out_used\n"
+            "  br label %%loop\n"
+            "loop:\n"
+            "  %%done = phi i64 [0, %%entry], [%%done, %%write], [%%next, %%wrote]\n"
+            "  %%more = icmp ult i64 %%done, %%used\n"
+            "  br i1 %%more, label %%write, label %%end\n"
+            "write:\n"
+            "  %%from = getelementptr [%zu x i8], [%zu x i8]* @out_buffer, i64 0, i64 %%done\n"
+            "  %%left = sub i64 %%used, %%done\n"
+            "  %%written = call i64 @write(i32 1, i8* %%from, i64 %%left)\n"
+            "  %%failed = icmp sle i64 %%written, 0\n"
+            "  %%retry = icmp eq i64 %%written, -1\n"
+            "  %%errno_ptr = call i32* @__errno_location()\n"
+            "  %%errno = load i32, i32* %%errno_ptr\n"
+            "  %%interrupted = icmp eq i32 %%errno, %i\n"
+            "  %%again = and i1 %%retry, %%interrupted\n"
+            "  br i1 %%again, label %%loop, label %%check\n"
+            "check:\n"
+            "  br i1 %%failed, label %%end, label %%wrote\n"
+            "wrote:\n"
+            "  %%next = add i64 %%done, %%written\n"
+            "  br label %%loop\n"
+            "end:\n"
+            "  store i64 0, i64* @out_used\n"
+            "  ret void\n"
+            "}\n"
+            "declare i32* @__errno_location()\n"
+            "define internal void @out_put(i8 %%c) {\n"
+            "entry:\n"
+            "  %%used = load i64, i64* @out_used\n"
+            "  %%to = getelementptr [%zu x i8], [%zu x i8]* @out_buffer, i64 0, i64 %%used\n"
+            "  store i8 %%c, i8* %%to\n"
+            "  %%next = add i64 %%used, 1\n"
+            "  store i64 %%next, i64* @out_used\n"
+            "  %%full = icmp eq i64 %%next, %zu\n"
+            "  %%line = load i1, i1* @out_line\n"
+            "  %%newline = icmp eq i8 %%c, 10\n"
+            "  %%ended = and i1 %%line, %%newline\n"
+            "  %%flush = or i1 %%full, %%ended\n"
+            "  br i1 %%flush, label %%write, label %%done\n"
+            "write:\n"
+            "  call void @out_flush()\n"
+            "  br label %%done\n"
+            "done:\n"
+            "  ret void\n"
+            "}\n",
+            OUTPUT_BUFFER_SIZE, OUTPUT_BUFFER_SIZE, OUTPUT_BUFFER_SIZE, EINTR,
+            OUTPUT_BUFFER_SIZE, OUTPUT_BUFFER_SIZE, OUTPUT_BUFFER_SIZE);
+
+    // Input is read in blocks too, in_get gives -1 at the end of it
+    fprintf(out,
+            "@in_buffer = internal global [%zu x i8] zeroinitializer\n"
+            "@in_used = internal global i64 0\n"
+            "@in_length = internal global i64 0\n"
+            "define internal i32 @in_get() {\n"
+            "entry:\n"
+            "  %%line = load i1, i1* @out_line\n"
+            "  br i1 %%line, label %%write, label %%check\n"
+            "write:\n"
+            "  call void @out_flush()\n"
+            "  br label %%check\n"
+            "check:\n"
+            "  %%used = load i64, i64* @in_used\n"
+            "  %%length = load i64, i64* @in_length\n"
+            "  %%empty = icmp eq i64 %%used, %%length\n"
+            "  br i1 %%empty, label %%read, label %%take\n"
+            "read:\n"
+            "  %%into = getelementptr [%zu x i8], [%zu x i8]* @in_buffer, i64 0, i64 0\n"
+            "  %%n = call i64 @read(i32 0, i8* %%into, i64 %zu)\n"
+            "  %%retry = icmp eq i64 %%n, -1\n"
+            "  %%errno_ptr = call i32* @__errno_location()\n"
+            "  %%errno = load i32, i32* %%errno_ptr\n"
+            "  %%interrupted = icmp eq i32 %%errno, %i\n"
+            "  %%again = and i1 %%retry, %%interrupted\n"
+            "  br i1 %%again, label %%read, label %%got\n"
+            "got:\n"
+            "  %%ended = icmp sle i64 %%n, 0\n"
+            "  br i1 %%ended, label %%end, label %%filled\n"
+            "filled:\n"
+            "  store i64 %%n, i64* @in_length\n"
+            "  br label %%take\n"
+            "take:\n"
+            "  %%at = phi i64 [%%used, %%check], [0, %%filled]\n"
+            "  %%from = getelementptr [%zu x i8], [%zu x i8]* @in_buffer, i64 0, i64 %%at\n"
+            "  %%c = load i8, i8* %%from\n"
+            "  %%next = add i64 %%at, 1\n"
+            "  store i64 %%next, i64* @in_used\n"
+            "  %%value = zext i8 %%c to i32\n"
+            "  ret i32 %%value\n"
+            "end:\n"
+            "  ret i32 -1\n"
+            "}\n",
+            OUTPUT_BUFFER_SIZE, OUTPUT_BUFFER_SIZE, OUTPUT_BUFFER_SIZE,
+            OUTPUT_BUFFER_SIZE, EINTR, OUTPUT_BUFFER_SIZE, OUTPUT_BUFFER_SIZE);
+
+    fprintf(out,
+            "define i32 @main() {\n"
+            "entry:\n"
+            "  %%tty = call i32 @isatty(i32 1)\n"
+            "  %%on_tty = icmp ne i32 %%tty, 0\n"
+            "  %%line = or i1 %%on_tty, %s\n"
+            "  store i1 %%line, i1* @out_line\n"
+            "  %%raw = call i8* @calloc(i64 %zu, i64 %zu)\n"
+            "  %%tape = bitcast i8* %%raw to %s*\n"
+            "  %%p = alloca i64\n"
+            "  store i64 0, i64* %%p\n",
+            bf_data->line_buffered ? "true" : "false",
+            emitter.cells, bf_data->cell_size, emitter.cell);
+
+    // Instructions up to here are known to be on the tape
+    int checked_until = 0;
+
+    for (int i = 0; ops[i].op != BF_END; i += bf_op_length(ops + i)){
+        if (i >= checked_until && !(ops[i].flags & BF_FLAG_BOUNDED)){
+            int lowest;
+            int reach = block_reach(ops, i, &checked_until, &lowest);
+            if (reach > 0)
+                llvm_check_reach(&emitter, reach);
+            if (lowest < 0)
+                llvm_check_lowest(&emitter, lowest);
+        }
+
+        const bf_op_t *op = ops + i;
+        int value;
+        switch(op->op){
+        case BF_ADD:
+            llvm_add(&emitter, op->offset, op->arg);
+            break;
+        case BF_MOVE:
+            llvm_move(&emitter, op->arg);
+            break;
+        case BF_GET:
+            llvm_get(&emitter, op->offset);
+            break;
+        case BF_PUT:
+            llvm_put(&emitter, op->offset);
+            break;
+        case BF_CLEAR:
+            llvm_set(&emitter, op->offset, 0);
+            break;
+        case BF_SET:
+            llvm_set(&emitter, op->offset, op->arg);
+            break;
+        case BF_WRITE:
+            for (int term = 1; term <= op->arg; term++)
+                fprintf(out, "  call void @out_put(i8 %i)\n", (int8_t) op[term].arg);
+            break;
+        case BF_SCAN:
+            llvm_scan(&emitter, op->arg);
+            break;
+        case BF_MUL_ADD:
+            llvm_mul_add(&emitter, op);
+            break;
+        case BF_PUT_RUN:
+            for (int term = 1; term <= op->arg; term++)
+                llvm_put(&emitter, op[term].offset);
+            break;
+        case BF_FIT:
+            llvm_check_reach(&emitter, op->arg);
+            break;
+        case BF_LOOP_START:
+            // Blocks of a loop are named after the index of its BF_LOOP_START
+            value = llvm_load(&emitter, 0);
+            fprintf(out,
+                    "  %%t%i = icmp eq %s %%t%i, 0\n"
+                    "  br i1 %%t%i, label %%after%i, label %%body%i%s\n"
+                    "body%i:\n",
+                    emitter.next, emitter.cell, value, emitter.next, i, i,
+                    llvm_weights(op, 0), i);
+            emitter.next++;
+            break;
+        case BF_LOOP_END:
+            value = llvm_load(&emitter, 0);
+            fprintf(out,
+                    "  %%t%i = icmp ne %s %%t%i, 0\n"
+                    "  br i1 %%t%i, label %%body%i, label %%after%i%s\n"
+                    "after%i:\n",
+                    emitter.next, emitter.cell, value, emitter.next,
+                    op->arg, op->arg, llvm_weights(ops + op->arg, 1), op->arg);
+            emitter.next++;
+            break;
+        }
+    }
+
+    fprintf(out,
+            "  call void @out_flush()\n"
+            "  ret i32 0\n"
+            "out_of_tape:\n"
+            "  call void @out_flush()\n"
+            "  call i64 @write(i32 2, i8* getelementptr ([%zu x i8], "
+            "[%zu x i8]* @out_of_tape, i64 0, i64 0), i64 %zu)\n"
+            "  call void @exit(i32 %i)\n"
+            "  unreachable\n"
+            "before_tape:\n"
+            "  call void @out_flush()\n"
+            "  call i64 @write(i32 2, i8* getelementptr ([%zu x i8], "
+            "[%zu x i8]* @before_tape, i64 0, i64 0), i64 %zu)\n"
+            "  call void @exit(i32 %i)\n"
+            "  unreachable\n"
+            "}\n"
+            "!0 = !{!\"branch_weights\", i32 %i, i32 1}\n"
+            "!1 = !{!\"branch_weights\", i32 1, i32 %i}\n",
+            sizeof(out_of_tape) - 3, sizeof(out_of_tape) - 3,
+            sizeof(out_of_tape) - 3, EX_SOFTWARE,
+            sizeof(before_tape) - 3, sizeof(before_tape) - 3,
+            sizeof(before_tape) - 3, EX_SOFTWARE,
+            LLVM_LIKELY_WEIGHT, LLVM_LIKELY_WEIGHT);
+}
+
+/* The IR has typed pointers, which LLVM 15 and 16 only read with
+   -opaque-pointers=0 and later versions not at all */
+#define LLVM_NEWEST 16
+
+// Major version of the `llc` on the PATH, or 0 if it cannot be told
+int llvm_version (void)
+{
+    FILE *llc = popen("llc --version 2>/dev/null", "r");
+    if (llc == NULL)
+        return 0;
+    char line[256];
+    int version = 0;
+    while (fgets(line, sizeof(line), llc) != NULL){
+        char *found = strstr(line, "LLVM version ");
+        if (found != NULL && version == 0)
+            version = atoi(found + strlen("LLVM version "));
+    }
+    pclose(llc);
+    return version;
+}
+
+/* Compiles the program contained in a bf_data_t through LLVM IR, optimized
+   by `opt` at `opt_level`. Depending on `output_filename` this writes the
+   optimized IR (ending in .ll, or standard output if it is empty), an
+   object file from `llc` (ending in .o), or an executable linked by `cc`.
+   With `native` set `llc` generates code for the CPU of this machine.
+   LLVM newer than LLVM_NEWEST gives STATUS_LLVM_TOO_NEW. */
+int bf_data_through_llvm (bf_data_t *bf_data, char *output_filename,
+                          int opt_level, int native)
+{
+    int version = llvm_version();
+    if (version == 0){
+        errno = ENOENT;
+        return STATUS_CANNOT_REACH_LLVM;
+    }
+    if (version > LLVM_NEWEST)
+        return STATUS_LLVM_TOO_NEW;
+    char *typed = version >= 15 ? "-opaque-pointers=0" : NULL;
+
+    char ir_filename[] = "/tmp/XXXXXX.ll";
+    char object_filename[] = "/tmp/XXXXXX.o";
+    int fd = mkstemps(ir_filename, 3);
+    if (fd == -1)
+        return STATUS_CANNOT_CREATE_TEMP_FILE;
+
+    FILE *ir = fdopen(fd, "w");
+    if (ir == NULL){
+        close(fd);
+        remove(ir_filename);
+        return STATUS_CANNOT_REACH_LLVM;
+    }
+    llvm_emit_module(bf_data, ir);
+    fclose(ir);
+
+    char level[4];
+    opt_flag(level, opt_level);
+    // llc has no -Os, the size is up to opt
+    char code_level[] = "-O2";
+    if (opt_level != OPT_SIZE)
+        code_level[2] = '0' + opt_level;
+    // Optional flags of llc, packed so the NULL of one left out ends the list
+    char *llc_flag = native ? "-mcpu=native" : typed;
+    char *llc_flag_after = native ? typed : NULL;
+
+    int status;
+    if (*output_filename == '\0' || has_suffix(output_filename, ".ll")){
+        char *opt[] = {"opt", level, "-S", ir_filename, "-o",
+                       *output_filename ? output_filename : "-", typed, NULL};
+        status = run_command(opt);
+    } else if (has_suffix(output_filename, ".o")){
+        char *llc[] = {"llc", code_level, "-filetype=obj", "-relocation-model=pic",
+                       ir_filename, "-o", output_filename, llc_flag, llc_flag_after, NULL};
+        char *opt[] = {"opt", level, ir_filename, "-o", ir_filename, typed, NULL};
+        status = run_command(opt);
+        if (status == STATUS_OK)
+            status = run_command(llc);
+    } else {
+        int object_fd = mkstemps(object_filename, 2);
+        if (object_fd == -1){
+            remove(ir_filename);
+            return STATUS_CANNOT_CREATE_TEMP_FILE;
+        }
+        close(object_fd);
+
+        char *opt[] = {"opt", level, ir_filename, "-o", ir_filename, typed, NULL};
+        char *llc[] = {"llc", code_level, "-filetype=obj", "-relocation-model=pic",
+                       ir_filename, "-o", object_filename, llc_flag, llc_flag_after, NULL};
+        char *cc[] = {"cc", object_filename, "-o", output_filename, NULL};
+        status = run_command(opt);
+        if (status == STATUS_OK)
+            status = run_command(llc);
+        if (status == STATUS_OK)
+            status = run_command(cc);
+        remove(object_filename);
+    }
+
+    remove(ir_filename);
+    return status;
+}
+
+/* Compiled programs are kept in a cache directory, named after a hash of
+   everything that goes into compiling them, so compiling the same program
+   the same way again is just a copy. FUCKED_UP_CACHE_DIR sets the
+   directory (empty turns the cache off), by default it is fucked-up in
+   XDG_CACHE_HOME or ~/.cache. Once it holds more than FUCKED_UP_CACHE_SIZE
+   bytes, 256 MiB by default, the least recently used programs go. */
+
+// Bump whenever the code compiled for the same instructions changes
+#define CACHE_VERSION 5
+
+#define CACHE_SIZE_DEFAULT ((off_t) 256 << 20)
+
+// FNV-1a, continuing from `hash`
+uint64_t cache_hash (uint64_t hash, const void *data, size_t size)
+{
+    const unsigned char *bytes = data;
+    for (size_t i = 0; i < size; i++){
+        hash ^= bytes[i];
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+// Key of the program in a bf_data_t, compiled for `goal` into `kind`
+uint64_t cache_key (bf_data_t *bf_data, int goal, int opt_level, int native,
+                    const char *kind)
+{
+    int settings[] = {CACHE_VERSION, goal, opt_level, native,
+                      (int) bf_data->cell_size, bf_data->line_buffered,
+                      bf_data->eof};
+    uint64_t hash = 0xcbf29ce484222325;
+    hash = cache_hash(hash, settings, sizeof(settings));
+    hash = cache_hash(hash, kind, strlen(kind));
+    return cache_hash(hash, bf_data->ops,
+                      (bf_data->length + 1) * sizeof(bf_op_t));
+}
+
+// Makes `path` and the directories leading up to it, as `mkdir -p` does
+int cache_make_directory (char *path)
+{
+    for (char *slash = strchr(path + 1, '/'); slash; slash = strchr(slash + 1, '/')){
+        *slash = '\0';
+        int made = mkdir(path, 0755) == 0 || errno == EEXIST;
+        *slash = '/';
+        if (!made)
+            return 0;
+    }
+    return mkdir(path, 0755) == 0 || errno == EEXIST;
+}
+
+// Writes the cache directory to `path`, returns 0 if there is none
+int cache_directory (char *path, size_t size)
+{
+    const char *dir = getenv("FUCKED_UP_CACHE_DIR");
+    const char *base;
+    int written;
+    if (dir != NULL)
+        written = snprintf(path, size, "%s", dir);
+    else if ((base = getenv("XDG_CACHE_HOME")) != NULL && *base != '\0')
+        written = snprintf(path, size, "%s/fucked-up", base);
+    else if ((base = getenv("HOME")) != NULL && *base != '\0')
+        written = snprintf(path, size, "%s/.cache/fucked-up", base);
+    else
+        return 0;
+    if (written <= 0 || (size_t) written >= size)
+        return 0;
+    return cache_make_directory(path);
+}
+
+// Copies the file `from` to `to`, which gets `mode`, returns 0 on failure
+int copy_file (const char *from, const char *to, mode_t mode)
+{
+    int in = open(from, O_RDONLY);
+    if (in == -1)
+        return 0;
+    int out = open(to, O_WRONLY | O_CREAT | O_TRUNC, mode);
+    if (out == -1 || fchmod(out, mode) != 0){
+        if (out != -1)
+            close(out);
+        close(in);
+        return 0;
+    }
+
+    char buffer[1 << 16];
+    ssize_t got;
+    int copied = 1;
+    while ((got = read(in, buffer, sizeof(buffer))) != 0){
+        if (got == -1 && errno == EINTR)
+            continue;
+        if (got == -1 || write(out, buffer, got) != got){
+            copied = 0;
+            break;
+        }
+    }
+    close(in);
+    if (close(out) != 0)
+        copied = 0;
+    if (!copied)
+        remove(to);
+    return copied;
+}
+
+// Entry in the cache directory, for `cache_evict`
+typedef struct {
+    char name[64];
+    off_t size;
+    time_t used;
+} cache_entry_t;
+
+int cache_entry_compare (const void *a, const void *b)
+{
+    time_t used_a = ((const cache_entry_t *) a)->used;
+    time_t used_b = ((const cache_entry_t *) b)->used;
+    return (used_a > used_b) - (used_a < used_b);
+}
+
+// Removes the least recently used programs until the cache fits in `max`
+void cache_evict (const char *dir, off_t max)
+{
+    DIR *directory = opendir(dir);
+    if (directory == NULL)
+        return;
+
+    size_t count = 0;
+    size_t entries_max = 64;
+    cache_entry_t *entries = malloc(entries_max * sizeof(cache_entry_t));
+    off_t total = 0;
+    struct dirent *entry;
+    while ((entry = readdir(directory)) != NULL){
+        char path[PATH_MAX];
+        struct stat info;
+        // Only files named like `cache_store` names them
+        if (strlen(entry->d_name) >= sizeof(entries->name)
+            || strspn(entry->d_name, "0123456789abcdef.o") != strlen(entry->d_name)
+            || snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name) >= (int) sizeof(path)
+            || stat(path, &info) != 0 || !S_ISREG(info.st_mode))
+            continue;
+        if (count == entries_max){
+            entries_max *= 2;
+            entries = realloc(entries, entries_max * sizeof(cache_entry_t));
+        }
+        strcpy(entries[count].name, entry->d_name);
+        entries[count].size = info.st_size;
+        entries[count].used = info.st_mtime;
+        total += info.st_size;
+        count++;
+    }
+    closedir(directory);
+
+    qsort(entries, count, sizeof(cache_entry_t), cache_entry_compare);
+    for (size_t i = 0; i < count && total > max; i++){
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/%s", dir, entries[i].name);
+        if (remove(path) == 0)
+            total -= entries[i].size;
+    }
+    free(entries);
+}
+
+/* Compiles the program in a bf_data_t for `goal` like `bf_data_through_gcc`
+   and `bf_data_through_llvm` do, unless the cache already has it, then it
+   is only copied to `output_filename`. LLVM IR is never cached. */
+int bf_data_through_cache (bf_data_t *bf_data, int goal, char *output_filename,
+                           int opt_level, int native)
+{
+    char dir[PATH_MAX - 32];
+    int cacheable = *output_filename != '\0'
+        && !(goal == GOAL_LLVM && has_suffix(output_filename, ".ll"))
+        && cache_directory(dir, sizeof(dir));
+
+    // Object files are not executable
+    const char *kind = has_suffix(output_filename, ".o") ? ".o" : "";
+    mode_t mode = *kind ? 0644 : 0775;
+
+    char cached[PATH_MAX];
+    if (cacheable){
+        snprintf(cached, sizeof(cached), "%s/%016llx%s", dir,
+                 (unsigned long long) cache_key(bf_data, goal, opt_level, native, kind),
+                 kind);
+        if (copy_file(cached, output_filename, mode)){
+            utimensat(AT_FDCWD, cached, NULL, 0); // Mark as recently used
+            return STATUS_OK;
+        }
+    }
+
+    int status = goal == GOAL_GCC
+        ? bf_data_through_gcc(bf_data, output_filename, opt_level, native)
+        : bf_data_through_llvm(bf_data, output_filename, opt_level, native);
+    if (status != STATUS_OK || !cacheable)
+        return status;
+
+    // Stored under a temporary name first, so nothing ever sees half of it
+    char stored[PATH_MAX];
+    snprintf(stored, sizeof(stored), "%s/tmp.XXXXXX", dir);
+    int fd = mkstemp(stored);
+    if (fd != -1){
+        close(fd);
+        if (copy_file(output_filename, stored, mode) && rename(stored, cached) == 0){
+            const char *size = getenv("FUCKED_UP_CACHE_SIZE");
+            cache_evict(dir, size != NULL && *size != '\0'
+                        ? (off_t) strtoll(size, NULL, 10) : CACHE_SIZE_DEFAULT);
+        } else
+            remove(stored);
+    }
+    return STATUS_OK;
+}
+
+/* A profile can be kept in a file, to compile the program with later. It
+   has the entries, iterations and instructions of every loop, by the
+   index of its BF_LOOP_START, for the instruction space it was made of:
+
+       fucked-up profile 1 HASH LENGTH TOTAL
+       INDEX ENTRIES ITERATIONS INSTRUCTIONS
+       ...
+
+   `profile_apply` marks the loops with it, for the emitters to go by. */
+
+#define PROFILE_VERSION 1
+
+// Share of all instructions a loop must run, at least, to be hot
+#define PROFILE_HOT_SHARE 100
+
+// Iterations per entry a loop must average, at least, to be hot
+#define PROFILE_HOT_ITERATIONS 4
+
+// Hash of the instructions of the program in a bf_data_t, without FLAGS
+uint64_t profile_program_hash (bf_data_t *bf_data)
+{
+    uint64_t hash = 0xcbf29ce484222325;
+    for (size_t i = 0; i < bf_data->length; i++){
+        bf_op_t op = bf_data->ops[i];
+        op.flags = 0;
+        hash = cache_hash(hash, &op, sizeof(op));
+    }
+    return hash;
+}
+
+// Writes the loops of a profile from the `counts` of a run to `filename`
+int profile_write (bf_data_t *bf_data, const uint64_t *counts,
+                   const char *filename)
+{
+    FILE *file = fopen(filename, "w");
+    if (file == NULL)
+        return STATUS_CANNOT_WRITE_PROFILE;
+
+    size_t found;
+    uint64_t total;
+    profile_loop_t *loops = profile_loops(bf_data, counts, &found, &total);
+    fprintf(file, "fucked-up profile %d %016llx %zu %llu\n", PROFILE_VERSION,
+            (unsigned long long) profile_program_hash(bf_data),
+            bf_data->length, (unsigned long long) total);
+    for (size_t l = 0; l < found; l++){
+        const bf_op_t *op = bf_data->ops + loops[l].start;
+        if (op->op == BF_LOOP_START)
+            fprintf(file, "%zu %llu %llu %llu\n", loops[l].start,
+                    (unsigned long long) counts[loops[l].start],
+                    (unsigned long long) counts[op->arg],
+                    (unsigned long long) loops[l].instructions);
+    }
+    free(loops);
+
+    return fclose(file) == 0 ? STATUS_OK : STATUS_CANNOT_WRITE_PROFILE;
+}
+
+/* Marks the loops of the program in a bf_data_t as hot or cold by the
+   profile in `filename`. A profile of something else is left alone, with
+   a warning, as the program still works without it. */
+int profile_apply (bf_data_t *bf_data, const char *filename)
+{
+    FILE *file = fopen(filename, "r");
+    if (file == NULL)
+        return STATUS_CANNOT_READ_PROFILE;
+
+    int version;
+    unsigned long long hash, total;
+    size_t length;
+    if (fscanf(file, "fucked-up profile %d %llx %zu %llu", &version, &hash,
+               &length, &total) != 4 || version != PROFILE_VERSION){
+        fclose(file);
+        return STATUS_CANNOT_READ_PROFILE;
+    }
+    if (hash != profile_program_hash(bf_data) || length != bf_data->length){
+        fprintf(stderr, "Profile %s is of another program, not using it\n",
+                filename);
+        fclose(file);
+        return STATUS_OK;
+    }
+
+    size_t index;
+    unsigned long long entries, iterations, instructions;
+    while (fscanf(file, "%zu %llu %llu %llu", &index, &entries, &iterations,
+                  &instructions) == 4){
+        bf_op_t *op = bf_data->ops + index;
+        if (index >= length || op->op != BF_LOOP_START)
+            continue;
+        if (entries == 0)
+            op->flags |= BF_FLAG_COLD;
+        else if (iterations >= PROFILE_HOT_ITERATIONS * entries
+                 && instructions >= total / PROFILE_HOT_SHARE)
+            op->flags |= BF_FLAG_HOT;
+    }
+    fclose(file);
+    return STATUS_OK;
+}
+
+/* Runs the program contained in a bf_data_t, which kept its positions, on
+   the switch interpreter, then writes the `top` hottest loops to stderr
+   and, unless `profile_filename` is empty, the profile to that file */
+int bf_data_profile (bf_data_t *bf_data, output_t *output, int top,
+                     const char *profile_filename)
+{
+    uint64_t *counts = calloc(bf_data->length + 1, sizeof(uint64_t));
+    int status = bf_data_run_counted(bf_data, output, counts);
+    output_flush(output);
+    if (status == STATUS_OK){
+        profile_report(bf_data, counts, top, stderr);
+        if (*profile_filename != '\0')
+            status = profile_write(bf_data, counts, profile_filename);
+    }
+    free(counts);
+    return status;
+}
+
+/* A snapshot keeps a run where it first reads input, for programs that
+   do a lot before that: a run from it starts there, the output up to it
+   written out at once. The file has a snapshot_header_t, that output, and
+   from the page at `tape_offset` the tape up to the last page the run
+   wrote to, with holes where it is all zeros. Runs map the tape copy on
+   write, so they can share its pages through the page cache. */
+
+#define SNAPSHOT_VERSION 1
+
+typedef struct {
+    char magic[16];    // "fucked-up snap"
+    uint64_t version;
+    uint64_t hash;     // Of the instructions, see `profile_program_hash`
+    uint64_t length;
+    uint64_t cell_size;
+    uint64_t insptr;   // Of the BF_GET the run stopped at
+    uint64_t memptr;
+    uint64_t output_length;
+    uint64_t tape_offset;
+    uint64_t tape_length;
+} snapshot_header_t;
+
+// Writes the run suspended in `slice`, which wrote what is in `output_fd`
+int snapshot_write (bf_data_t *bf_data, bf_slice_t *slice, int output_fd,
+                    const char *filename)
+{
+    size_t page = sysconf(_SC_PAGESIZE);
+    snapshot_header_t header = {"fucked-up snap", SNAPSHOT_VERSION,
+                                profile_program_hash(bf_data), bf_data->length,
+                                bf_data->cell_size, slice->insptr, slice->memptr,
+                                lseek(output_fd, 0, SEEK_END), 0, 0};
+    header.tape_offset = (sizeof(header) + header.output_length + page - 1)
+        / page * page;
+
+    // Stored under a temporary name first, so no run ever maps half of it
+    char stored[PATH_MAX];
+    snprintf(stored, sizeof(stored), "%s.XXXXXX", filename);
+    int fd = mkstemp(stored);
+    if (fd == -1)
+        return STATUS_CANNOT_WRITE_SNAPSHOT;
+    fchmod(fd, 0644); // For other users to start from too
+    int written = pwrite(fd, &header, sizeof(header), 0) == sizeof(header);
+
+    unsigned char data[OUTPUT_BUFFER_SIZE];
+    off_t at = 0;
+    ssize_t n;
+    while (written && (n = pread(output_fd, data, sizeof(data), at)) > 0){
+        written = pwrite(fd, data, n, sizeof(header) + at) == n;
+        at += n;
+    }
+
+    /* Pages never touched are not in memory, so only those that are need
+       to be looked at, and only those with something on them written */
+    size_t pages = GUARDED_TAPE_SIZE / page;
+    unsigned char *resident = malloc(pages);
+    written = written && mincore(slice->tape.start, GUARDED_TAPE_SIZE, resident) == 0;
+    for (size_t p = 0; written && p < pages; p++){
+        const char *start = slice->tape.start + p * page;
+        if (!(resident[p] & 1) || (start[0] == 0
+                                   && memcmp(start, start + 1, page - 1) == 0))
+            continue;
+        written = pwrite(fd, start, page, header.tape_offset + p * page) == (ssize_t) page;
+        header.tape_length = (p + 1) * page;
+    }
+    free(resident);
+
+    written = written
+        && ftruncate(fd, header.tape_offset + header.tape_length) == 0
+        && pwrite(fd, &header, sizeof(header), 0) == sizeof(header);
+    if (close(fd) != 0 || !written || rename(stored, filename) != 0){
+        remove(stored);
+        return STATUS_CANNOT_WRITE_SNAPSHOT;
+    }
+    return STATUS_OK;
+}
+
+/* Sets up `slice` to go on with the run kept in the snapshot `filename`,
+   and writes its output so far, if it is one of this program */
+int snapshot_restore (bf_data_t *bf_data, bf_slice_t *slice, output_t *output,
+                      const char *filename)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1)
+        return STATUS_CANNOT_READ_SNAPSHOT;
+
+    snapshot_header_t header;
+    struct stat info;
+    size_t page = sysconf(_SC_PAGESIZE);
+    if (pread(fd, &header, sizeof(header), 0) != sizeof(header)
+        || fstat(fd, &info) != 0
+        || memcmp(header.magic, "fucked-up snap", 15) != 0
+        || header.version != SNAPSHOT_VERSION
+        || header.hash != profile_program_hash(bf_data)
+        || header.length != bf_data->length
+        || header.cell_size != bf_data->cell_size
+        || header.insptr >= bf_data->length
+        || bf_data->ops[header.insptr].op != BF_GET
+        || header.memptr >= GUARDED_TAPE_SIZE / header.cell_size
+        || header.tape_offset % page != 0
+        || header.tape_offset < sizeof(header) + header.output_length
+        || header.tape_length > GUARDED_TAPE_SIZE
+        || (uint64_t) info.st_size < header.tape_offset + header.tape_length){
+        close(fd);
+        return STATUS_CANNOT_READ_SNAPSHOT;
+    }
+
+    if (guarded_tape_map(&slice->tape) != STATUS_OK){
+        close(fd);
+        return STATUS_CANNOT_MAP_MEMORY;
+    }
+    if (header.tape_length > 0
+        && mmap(slice->tape.start, header.tape_length, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_FIXED, fd, header.tape_offset) == MAP_FAILED){
+        guarded_tape_unmap(&slice->tape);
+        close(fd);
+        return STATUS_CANNOT_MAP_MEMORY;
+    }
+    slice->tape.restored = header.tape_length;
+    slice->tape_mode = TAPE_GUARDED;
+    slice->memory = slice->tape.start;
+    slice->memmax = GUARDED_TAPE_SIZE / header.cell_size;
+    slice->memptr = header.memptr;
+    slice->insptr = header.insptr;
+
+    off_t at = 0;
+    ssize_t n = 1;
+    while (at < (off_t) header.output_length && n > 0){
+        size_t size = header.output_length - at < OUTPUT_BUFFER_SIZE
+            ? header.output_length - at : OUTPUT_BUFFER_SIZE;
+        n = pread(fd, output_reserve(output, size), size, sizeof(header) + at);
+        if (n > 0){
+            output_commit(output, n);
+            at += n;
+        }
+    }
+    close(fd);
+    return STATUS_OK;
+}
+
+/* Runs the program contained in a bf_data_t, which is to be on a guarded
+   tape, like `bf_data_run_quota` does, from the snapshot `filename` if there is one
+   of it. If not, the run takes one where it first reads input, on the
+   switch interpreter, and goes on from there. */
+int bf_data_run_snapshot (bf_data_t *bf_data, output_t *output, int jit,
+                          bf_slice_t *slice, const char *filename)
+{
+    long budget = slice->budget;
+    int status = snapshot_restore(bf_data, slice, output, filename);
+    if (status == STATUS_CANNOT_READ_SNAPSHOT){
+        // Ask for input there is not yet, keeping the output until then
+        FILE *copy = tmpfile();
+        if (copy == NULL)
+            return STATUS_CANNOT_CREATE_TEMP_FILE;
+        input_read_t *read = output->read;
+        output->read = input_read_later;
+        output->copy_fd = fileno(copy);
+        status = bf_data_run_slice(bf_data, output, slice);
+        output_flush(output);
+        output->copy_fd = -1;
+        output->read = read;
+
+        if (status == STATUS_NEEDS_INPUT
+            && snapshot_write(bf_data, slice, fileno(copy), filename) != STATUS_OK)
+            fprintf(stderr, "Could not write snapshot %s\n", filename);
+        fclose(copy);
+        if (status != STATUS_NEEDS_INPUT)
+            return status == STATUS_SUSPENDED ? STATUS_OVER_QUOTA : status;
+    } else if (status != STATUS_OK)
+        return status;
+
+    slice->budget = budget;
+    return bf_data_run_quota(bf_data, output, jit, slice);
+}
+
+/* Runs the program contained in a bf_data_t on the switch interpreter, then
+   writes the `top` sequences of instructions it ran most to stderr */
+int bf_data_sequences (bf_data_t *bf_data, output_t *output, int top)
+{
+    uint64_t *counts = calloc(bf_data->length + 1, sizeof(uint64_t));
+    int status = bf_data_run_counted(bf_data, output, counts);
+    output_flush(output);
+    if (status == STATUS_OK)
+        sequence_report(bf_data, counts, top, stderr);
+    free(counts);
+    return status;
+}
+
+/* Benchmarks run the program a number of times on every engine and report
+   the fastest and the median wall time, the instructions the CPU retired
+   (through perf events, when the kernel lets us count them), how many
+   instructions of instruction space that is per second and the peak RSS.
+   Every run is a child process, with /dev/null as input and output. */
+
+enum {
+    BENCH_SWITCH,
+    BENCH_THREADED,
+    BENCH_TIERED,
+    BENCH_JIT,
+    BENCH_GCC,
+    BENCH_LLVM,
+    BENCH_ENGINES,
+};
+
+static const char *const bench_engine_names[BENCH_ENGINES] = {
+    "switch", "threaded", "tiered", "jit", "gcc", "llvm",
+};
+
+// One run of a benchmark
+typedef struct {
+    double seconds;
+    long long instructions; // -1 if they could not be counted
+    long max_rss;           // KiB
+} bench_sample_t;
+
+// Counter of user space instructions retired by us and our children, or -1
+int bench_counter_open (void)
+{
+#if defined(__linux__)
+    struct perf_event_attr attr = {
+        .type = PERF_TYPE_HARDWARE,
+        .size = sizeof(attr),
+        .config = PERF_COUNT_HW_INSTRUCTIONS,
+        .disabled = 1,
+        .inherit = 1,
+        .exclude_kernel = 1,
+        .exclude_hv = 1,
+    };
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    return -1;
+#endif
+}
+
+/* Runs the program once on `engine`, which for BENCH_GCC and BENCH_LLVM
+   means running the executable `program` */
+int bench_sample (bf_data_t *bf_data, int engine, char *program, int counter,
+                  bench_sample_t *sample)
+{
+    static output_t output;
+#if defined(__linux__)
+    if (counter != -1){
+        ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pid_t pid = fork();
+    if (pid == 0){
+        int null = open("/dev/null", O_RDWR);
+        dup2(null, STDIN_FILENO);
+        dup2(null, STDOUT_FILENO);
+        close(null);
+
+        int status = STATUS_OK;
+        output_open(&output, STDOUT_FILENO, bf_data->line_buffered, STDIN_FILENO);
+        switch (engine){
+        case BENCH_SWITCH:
+            status = bf_data_run(bf_data, &output);
+            break;
+        case BENCH_THREADED:
+            status = bf_data_run_threaded(bf_data, &output);
+            break;
+        case BENCH_TIERED: {
+            bf_slice_t slice = {0};
+            status = bf_data_run_tiered(bf_data, &output, &slice);
+            break;
+        }
+        case BENCH_JIT:
+            status = bf_data_run_jit(bf_data, &output);
+            break;
+        default:
+            execl(program, program, (char *) NULL);
+            _exit(EX_UNAVAILABLE);
+        }
+        output_close(&output);
+        _exit(status == STATUS_OK ? 0 : EX_SOFTWARE);
+    }
+    if (pid == -1)
+        return STATUS_COMMAND_FAILED;
+
+    int wstatus;
+    struct rusage usage;
+    while (wait4(pid, &wstatus, 0, &usage) == -1)
+        if (errno != EINTR)
+            return STATUS_COMMAND_FAILED;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    sample->seconds = (end.tv_sec - start.tv_sec)
+        + (end.tv_nsec - start.tv_nsec) / 1e9;
+    sample->max_rss = usage.ru_maxrss;
+    sample->instructions = -1;
+#if defined(__linux__)
+    long long instructions;
+    if (counter != -1){
+        ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(counter, &instructions, sizeof(instructions)) == sizeof(instructions))
+            sample->instructions = instructions;
+    }
+#endif
+
+    if (!WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != 0){
+        fprintf(stderr, "%s did not finish successfully\n", bench_engine_names[engine]);
+        return STATUS_COMMAND_FAILED;
+    }
+    return STATUS_OK;
+}
+
+int bench_sample_compare (const void *a, const void *b)
+{
+    double x = ((const bench_sample_t *) a)->seconds;
+    double y = ((const bench_sample_t *) b)->seconds;
+    return (x > y) - (x < y);
+}
+
+/* Runs the program in a bf_data_t `runs` times on every engine that is
+   available, the compiled ones built at `opt_level`, and writes a report to
+   `out`, as JSON if `json` is set and as CSV otherwise */
+int bf_data_bench (bf_data_t *bf_data, int runs, int opt_level, int native,
+                   FILE *out, int json)
+{
+    // Count the instructions the benchmark goes through once
+    static output_t output;
+    uint64_t *counts = calloc(bf_data->length + 1, sizeof(uint64_t));
+    int null = open("/dev/null", O_WRONLY);
+    output_open(&output, null, 0, -1);
+    int status = bf_data_run_counted(bf_data, &output, counts);
+    output_close(&output);
+    close(null);
+    uint64_t dispatches = 0;
+    for (size_t i = 0; i < bf_data->length; i++)
+        dispatches += counts[i];
+    free(counts);
+    if (status != STATUS_OK)
+        return status;
+
+    int counter = bench_counter_open();
+    bench_sample_t *samples = malloc(runs * sizeof(bench_sample_t));
+
+    if (json)
+        fprintf(out, "{\"runs\": %d, \"dispatches\": %llu, \"engines\": [",
+                runs, (unsigned long long) dispatches);
+    else
+        fputs("engine,runs,seconds_min,seconds_median,instructions,"
+              "dispatches,dispatches_per_second,max_rss_kib\n", out);
+
+    int reported = 0;
+    for (int engine = 0; engine < BENCH_ENGINES; engine++){
+#if !defined(__x86_64__)
+        if (engine == BENCH_JIT)
+            continue;
+#endif
+        // Only the running of compiled programs is timed, not the compiling
+        char program[] = "/tmp/XXXXXX";
+        if (engine == BENCH_GCC || engine == BENCH_LLVM){
+            int fd = mkstemp(program);
+            if (fd == -1){
+                status = STATUS_CANNOT_CREATE_TEMP_FILE;
+                break;
+            }
+            close(fd);
+            int built = engine == BENCH_GCC
+                ? bf_data_through_gcc(bf_data, program, opt_level, native)
+                : bf_data_through_llvm(bf_data, program, opt_level, native);
+            if (built != STATUS_OK){
+                fprintf(stderr, "Skipping %s, it could not build the program\n",
+                        bench_engine_names[engine]);
+                remove(program);
+                continue;
+            }
+        }
+
+        int run;
+        for (run = 0; run < runs; run++)
+            if (bench_sample(bf_data, engine, program, counter, samples + run) != STATUS_OK)
+                break;
+        if (engine == BENCH_GCC || engine == BENCH_LLVM)
+            remove(program);
+        if (run < runs)
+            continue;
+
+        qsort(samples, runs, sizeof(bench_sample_t), bench_sample_compare);
+        double median = runs % 2 ? samples[runs / 2].seconds
+            : (samples[runs / 2 - 1].seconds + samples[runs / 2].seconds) / 2;
+        long long instructions = samples[0].instructions;
+        long max_rss = 0;
+        for (run = 0; run < runs; run++){
+            if (samples[run].instructions < instructions)
+                instructions = samples[run].instructions;
+            if (samples[run].max_rss > max_rss)
+                max_rss = samples[run].max_rss;
+        }
+        double rate = median > 0 ? dispatches / median : 0;
+
+        if (json){
+            fprintf(out, "%s\n  {\"engine\": \"%s\", \"seconds_min\": %.6f, "
+                    "\"seconds_median\": %.6f, \"instructions\": ",
+                    reported ? "," : "", bench_engine_names[engine],
+                    samples[0].seconds, median);
+            if (instructions < 0)
+                fputs("null", out);
+            else
+                fprintf(out, "%lld", instructions);
+            fprintf(out, ", \"dispatches_per_second\": %.0f, \"max_rss_kib\": %ld}",
+                    rate, max_rss);
+        } else {
+            fprintf(out, "%s,%d,%.6f,%.6f,", bench_engine_names[engine], runs,
+                    samples[0].seconds, median);
+            if (instructions >= 0)
+                fprintf(out, "%lld", instructions);
+            fprintf(out, ",%llu,%.0f,%ld\n", (unsigned long long) dispatches,
+                    rate, max_rss);
+        }
+        reported++;
+    }
+    if (json)
+        fputs("\n]}\n", out);
+
+    free(samples);
+    if (counter != -1)
+        close(counter);
+    return status;
+}
 
-// Input Modes
-enum {
-    READ_FILE,
-    READ_ARG,
-    READ_STDIN,
+/* libfuckedup, as declared in fucked-up.h. A program is instruction space
+   as `main` would run it, a context is the caller's tape and the output_t
+   runs on it write to, so running needs no memory of its own. A suspended
+   run is kept in `slice`, and `program` is what it runs. */
+struct fucked_up_program {
+    bf_data_t bf_data;
 };
 
-// Output Modes
-enum {
-    WRITE_FILE,
-    WRITE_STDOUT,
+struct fucked_up_context {
+    void *tape;
+    size_t tape_size;
+    input_read_t *read;
+    void *source;
+    output_t output;
+    bf_slice_t slice;
+    const fucked_up_program_t *program;
 };
 
-// Goals
-enum {
-    GOAL_EVAL,
-    GOAL_GCC,
-    GOAL_LLVM, // TODO
-};
+fucked_up_program_t *fucked_up_compile (const char *text, size_t length,
+                                        int cell_bits, int eof, int *status)
+{
+    int result = FUCKED_UP_OK;
+    fucked_up_program_t *program = NULL;
+    if ((cell_bits != 8 && cell_bits != 16 && cell_bits != 32)
+        || (eof != EOF_MINUS_ONE && eof != EOF_ZERO && eof != EOF_UNCHANGED)
+        || (text == NULL && length != 0)
+        || (program = malloc(sizeof(fucked_up_program_t))) == NULL)
+        result = FUCKED_UP_INVALID;
+    else {
+        program->bf_data = (bf_data_t) {NULL, 0, cell_bits / 8, TAPE_FIXED, 0, eof, NULL, 0};
+        source_t source = {text, length, NULL, NULL};
+        if (bf_data_from_source(&program->bf_data, &source) == STATUS_OK)
+            bf_data_optimize(&program->bf_data, CONSTANTS_STEP_MAX);
+        else {
+            free(program);
+            program = NULL;
+            result = FUCKED_UP_UNBALANCED_LOOP;
+        }
+    }
 
-// Container for all the program data
-typedef struct {
-    int * instructions;
-} bf_data_t;
+    if (status != NULL)
+        *status = result;
+    return program;
+}
 
-// Maps brainfuck instruction to enum element
-int bf_instruction(char c)
-{
-    switch(c){
-    case '+':
-        return BF_INC;
-    case '-':
-        return BF_DEC;
-    case ',':
-        return BF_GET;
-    case '.':
-        return BF_PUT;
-    case '>':
-        return BF_NEXT;
-    case '<':
-        return BF_PREV;
-    case '[':
-        return BF_LOOP_START;
-    case ']':
-        return BF_LOOP_END;
-    default:
-        return BF_UNDEFINED;
+void fucked_up_program_free (fucked_up_program_t *program)
+{
+    if (program != NULL)
+        free(program->bf_data.ops);
+    free(program);
+}
+
+fucked_up_context_t *fucked_up_context_new (void *tape, size_t tape_size)
+{
+    if (tape == NULL || tape_size == 0)
+        return NULL;
+    fucked_up_context_t *context = calloc(1, sizeof(fucked_up_context_t));
+    if (context != NULL){
+        context->tape = tape;
+        context->tape_size = tape_size;
     }
+    return context;
+}
+
+void fucked_up_context_free (fucked_up_context_t *context)
+{
+    free(context);
 }
 
-// Reads instructions from brainfuck file
-int bf_data_from_file (bf_data_t * bf_data, FILE *file)
+void fucked_up_context_input (fucked_up_context_t *context,
+                              fucked_up_read_t *read, void *user)
 {
-    // Size of, and instruction space itself.
-    int inssize = 2;
-    int * instructions = calloc(inssize,sizeof(int));
+    context->read = read;
+    context->source = user;
+}
 
-    int i = 0; // Needed inssize
-    int balance = 0; // Keeps track of BF_LOOP_START and BF_LOOP_END balance
+/* Goes on with the run in `context` for `budget` back edges, ending it
+   unless it gets suspended again */
+static int fucked_up_go (fucked_up_context_t *context, long budget,
+                         size_t *output_length)
+{
+    bf_data_t *bf_data = (bf_data_t *) &context->program->bf_data;
+    bf_slice_t *slice = &context->slice;
+    output_t *output = &context->output;
+    size_t cells = context->tape_size / bf_data->cell_size;
 
-    char c;
-    int instruction;
-    while ((c = fgetc(file)) != EOF){
-        // We do not know how many instructions will be read
-        // When instruction space too small, just double it
-        // Amortized this is still O(n) time lost for n instructions
-        while (i >= inssize - 1){
-            int new_inssize = inssize * 2;
-            instructions = realloc(instructions, new_inssize * sizeof(int));
-            for (int i = inssize; i < new_inssize; i++)
-                instructions[i] = BF_UNDEFINED;
-            inssize = new_inssize;
-        }
+    // Programs `bounds` proved to fit on the tape need no checks
+    int bounded = bf_data->tape_cells != 0 && bf_data->tape_cells <= cells;
 
-        if((instruction = bf_instruction(c)) != BF_UNDEFINED){
-            instructions[i] = instruction;
-            i++;
-            if (instruction == BF_LOOP_START)
-                balance++;
-            else if (instruction == BF_LOOP_END)
-                balance--;
-            // Error if order of BF_LOOP_END and BF_LOOP_START tags is wrong
-            if (balance < 0){
-                return STATUS_LOOP_END_BEFORE_START;
-            }
-        }
-    }
+    slice->budget = budget;
+    active_output = output;
+    volatile int status = STATUS_OK;
+    sigjmp_buf escape;
+    if (sigsetjmp(escape, 0) != 0)
+        goto escaped;
+    active_escape = &escape;
+#define RUN(cell_size) \
+    status = bounded \
+        ? bf_data_run_cells(bf_data, output, cell_size, TAPE_BOUNDED, \
+                            NULL, context->tape, cells, slice) \
+        : bf_data_run_cells(bf_data, output, cell_size, TAPE_FIXED, \
+                            NULL, context->tape, cells, slice)
 
-    // Error if BF_LOOP_START and BF_LOOP_END aren't balanced
-    if (balance != 0){
-        return STATUS_UNBALANCED_LOOP;
+    switch(bf_data->cell_size){
+    case 1:
+        RUN(1);
+        break;
+    case 2:
+        RUN(2);
+        break;
+    default:
+        RUN(4);
     }
+#undef RUN
+escaped:
+    active_escape = NULL;
+    int suspended = status == STATUS_SUSPENDED || status == STATUS_NEEDS_INPUT;
+    if (suspended)
+        output_flush(output);
+    else
+        output_close(output);
+    if (output_length != NULL)
+        *output_length = output->into_used;
+    active_output = NULL;
+    if (suspended && output->into_used <= output->into_size)
+        return status == STATUS_SUSPENDED ? FUCKED_UP_SUSPENDED
+                                          : FUCKED_UP_NEEDS_INPUT;
+
+    slice->memory = NULL;
+    if (status == STATUS_LEFT_TAPE)
+        return FUCKED_UP_LEFT_TAPE;
+    if (output->into_used > output->into_size)
+        return FUCKED_UP_OUTPUT_TOO_LARGE;
+    return FUCKED_UP_OK;
+}
 
-    bf_data->instructions = instructions;
+int fucked_up_run_for (const fucked_up_program_t *program,
+                       fucked_up_context_t *context,
+                       const void *input, size_t input_length,
+                       void *output, size_t output_size, long budget,
+                       size_t *output_length)
+{
+    if (context->tape_size < program->bf_data.cell_size || budget < 0
+        || (input == NULL && input_length != 0)
+        || (output == NULL && output_size != 0))
+        return FUCKED_UP_INVALID;
 
-    return STATUS_OK;
+    context->program = program;
+    context->slice.memory = NULL;
+    output_open_memory(&context->output, output, output_size, input, input_length);
+    context->output.read = context->read;
+    context->output.source = context->source;
+    return fucked_up_go(context, budget, output_length);
 }
 
-void compress (bf_data_t *bf_data)
+int fucked_up_run (const fucked_up_program_t *program, fucked_up_context_t *context,
+                   const void *input, size_t input_length,
+                   void *output, size_t output_size, size_t *output_length)
 {
-    // Get required size of instruction space
-    int inssize = 1;
-    int i;
-    char prev = BF_UNDEFINED;
-    char cur = BF_UNDEFINED;
-    for (i = 0; bf_data->instructions[i] != 0; i++){
-        /* All instructions except loops and IO take 2 spots for any number,
-           loop constructs always take 2 spots per operator,
-           IO (everything else) just takes one spot */
-        cur = bf_data->instructions[i];
-        switch(cur){
-        case BF_INC:
-        case BF_DEC:
-        case BF_NEXT:
-        case BF_PREV:
-            if (cur != prev)
-                inssize += 2;
-            break;
-        case BF_LOOP_START:
-        case BF_LOOP_END:
-            inssize += 2;
-            break;
-        default:
-            inssize++;
-        }
-        prev = cur;
+    return fucked_up_run_for(program, context, input, input_length,
+                             output, output_size, LONG_MAX, output_length);
+}
+
+int fucked_up_resume (fucked_up_context_t *context, long budget,
+                      size_t *output_length)
+{
+    if (context->slice.memory == NULL || budget < 0)
+        return FUCKED_UP_INVALID;
+    return fucked_up_go(context, budget, output_length);
+}
+
+const char *fucked_up_status_message (int status)
+{
+    switch (status){
+    case FUCKED_UP_OK:
+        return "No problem";
+    case FUCKED_UP_UNBALANCED_LOOP:
+        return "BF_LOOP_START and BF_LOOP_END were not balanced";
+    case FUCKED_UP_LEFT_TAPE:
+        return "The memory pointer left the tape";
+    case FUCKED_UP_OUTPUT_TOO_LARGE:
+        return "The output did not fit";
+    case FUCKED_UP_INVALID:
+        return "Invalid argument, or out of memory";
+    case FUCKED_UP_SUSPENDED:
+        return "The run used up its budget";
+    case FUCKED_UP_NEEDS_INPUT:
+        return "The run is waiting for input";
+    default:
+        return "Unknown error";
     }
+}
+
+/* A run of a program in a batch, from a line of its manifest. The output
+   goes to the file `output`, and input comes from the file `input`, or
+   from nowhere if that is NULL. */
+typedef struct {
+    char *program;
+    char *input;
+    char *output;
+    size_t line;       // Of the manifest
+    bf_data_t *loaded; // The program, shared with every job that runs it
+    int status;
+} batch_job_t;
 
-    // Allocate memory for compressed version
-    int *compressed = calloc(inssize,sizeof(int));
+/* Jobs a worker still has to run. It takes them from the front, other
+   workers that ran out of jobs steal them from the back. */
+typedef struct {
+    pthread_mutex_t lock;
+    size_t *jobs;
+    size_t front;
+    size_t back;
+} batch_queue_t;
 
-    // Pointer-offsets for instruction spaces
-    int i_old = 0;
-    int i_new = 0;
+// A batch of jobs, and how to run them
+typedef struct {
+    batch_job_t *jobs;
+    size_t length;
+    bf_data_t *programs; // Every distinct one, loaded
+    size_t loaded;
+    batch_queue_t *queues;
+    int workers;
+    int goal;   // GOAL_EVAL or GOAL_JIT
+    int engine; // For GOAL_EVAL
+    int line_buffered;
+    long quota; // Back edges a job may take, if not negative
+} batch_t;
 
-    // Tokens under compression
-    int compressing = BF_UNDEFINED;
+// Worker running jobs of a batch
+typedef struct {
+    batch_t *batch;
+    int index;
+    pthread_t thread;
+} batch_worker_t;
 
-    /* Iterate through all of original intruction space, replacing
-       BF_INCs, BF_DECs, BF_NEXTs, and BF_PREVs by: TOKEN AMOUNT;
-       and replacing BF_LOOP_STARTs and BF_LOOP_ENDs by TOKEN DESTINATION; */
-    while (bf_data->instructions[i_old] != 0) {
-        switch(bf_data->instructions[i_old]){
-        case BF_INC:
-            if (compressing != BF_INC){
-                compressing = BF_INC;
-                compressed[i_new] = BF_INC;
-                i_new++;
-            } else {
-                i_new--;
-            }
-            compressed[i_new]++;
-            break;
-        case BF_DEC:
-            if (compressing != BF_DEC){
-                compressing = BF_DEC;
-                compressed[i_new] = BF_DEC;
-                i_new++;
-            } else {
-                i_new--;
-            }
-            compressed[i_new]++;
-            break;
-        case BF_NEXT:
-            if (compressing != BF_NEXT){
-                compressing = BF_NEXT;
-                compressed[i_new] = BF_NEXT;
-                i_new++;
-            } else {
-                i_new--;
-            }
-            compressed[i_new]++;
-            break;
-        case BF_PREV:
-            if (compressing != BF_PREV){
-                compressing = BF_PREV;
-                compressed[i_new] = BF_PREV;
-                i_new++;
-            } else {
-                i_new--;
-            }
-            compressed[i_new]++;
-            break;
-        case BF_LOOP_START:
-            compressing = BF_UNDEFINED;
-            compressed[i_new] = BF_LOOP_START;
-            i_new++; // Allow room to set jump by loop-end compression
-            break;
-        case BF_LOOP_END:
-            compressing = BF_UNDEFINED;
-            compressed[i_new] = BF_LOOP_END;
-
-            // seek BF_LOOP_START matching this BF_LOOP_END
-            int counter = 0;
-            int loop_start = i_new;
-            while(compressed[loop_start] != BF_LOOP_START || counter != 0){
-                if (compressed[loop_start] == BF_LOOP_START)
-                    counter--;
-                loop_start--;
-                if(compressed[loop_start] == BF_LOOP_END)
-                    counter++;
-            }
-            // Set pointer from start to end, and from end to start
-            compressed[loop_start + 1] = i_new;
-            i_new++;
-            compressed[i_new] = loop_start;
+/* Reads the jobs of a manifest: one per line, as the files of the program,
+   its input (- for none) and its output, separated by whitespace. Empty
+   lines and lines starting with # are left out. */
+int batch_read_manifest (batch_t *batch, const char *filename)
+{
+    FILE *manifest = fopen(filename, "r");
+    if (manifest == NULL)
+        return STATUS_CANNOT_READ_MANIFEST;
+
+    size_t max = 16;
+    batch->jobs = malloc(max * sizeof(batch_job_t));
+    batch->length = 0;
+
+    char *text = NULL;
+    size_t text_max = 0;
+    size_t line = 0;
+    int status = STATUS_OK;
+    while (getline(&text, &text_max, manifest) != -1){
+        line++;
+        char *rest;
+        char *fields[4];
+        int n = 0;
+        for (char *field = strtok_r(text, " \t\r\n", &rest);
+             field != NULL && n < 4; field = strtok_r(NULL, " \t\r\n", &rest))
+            fields[n++] = field;
+        if (n == 0 || fields[0][0] == '#')
+            continue;
+        if (n != 3){
+            fprintf(stderr, "%s:%zu: expected a program, input and output\n",
+                    filename, line);
+            status = STATUS_CANNOT_READ_MANIFEST;
             break;
-        default:
-            compressing = BF_UNDEFINED;
-            compressed[i_new] = bf_data->instructions[i_old];
         }
-        i_old++;
-        i_new++;
+
+        if (batch->length == max){
+            max *= 2;
+            batch->jobs = realloc(batch->jobs, max * sizeof(batch_job_t));
+        }
+        batch->jobs[batch->length++] = (batch_job_t) {
+            strdup(fields[0]),
+            strcmp(fields[1], "-") == 0 ? NULL : strdup(fields[1]),
+            strdup(fields[2]),
+            line, NULL, STATUS_OK,
+        };
     }
+    if (ferror(manifest))
+        status = STATUS_CANNOT_READ_MANIFEST;
 
-    // Replace instruction space by compressed instruction space
-    free(bf_data->instructions);
-    bf_data->instructions = compressed;
+    free(text);
+    fclose(manifest);
+    return status;
 }
 
-void reallocate_runtime_memory(int **memory, size_t *memmax, size_t memptr) {
-    int new_memmax = *memmax;
-    while (memptr >= new_memmax)
-        new_memmax *=2;
-
-    *memory = realloc(*memory, new_memmax * sizeof(int)); // Preserves old content
-
-    // Initialize the extra memory to 0
-    for (int i = *memmax; i < new_memmax; i++)
-        (*memory)[i] = 0;
-
-    // Update current maximum
-    *memmax = new_memmax;
+// Orders pointers to jobs by their program
+int batch_job_compare (const void *a, const void *b)
+{
+    return strcmp((*(batch_job_t *const *) a)->program,
+                  (*(batch_job_t *const *) b)->program);
 }
 
-// Runs the program contained in a bf_data_t
-int bf_data_run (bf_data_t *bf_data, FILE * output_file)
+/* Loads and optimizes every program of a batch once, however many jobs
+   run it, like `template` says. A job whose program cannot be loaded gets
+   the status of why. */
+void batch_load (batch_t *batch, const bf_data_t *template, long steps_max)
 {
-    // Current place in instruction space
-    size_t insptr = 0;
+    batch_job_t **sorted = malloc((batch->length + 1) * sizeof(batch_job_t *));
+    for (size_t i = 0; i < batch->length; i++)
+        sorted[i] = batch->jobs + i;
+    qsort(sorted, batch->length, sizeof(batch_job_t *), batch_job_compare);
 
-    // Maximum and current index in memory space
-    size_t memmax = 1;
-    size_t memptr = 0;
+    batch->programs = calloc(batch->length + 1, sizeof(bf_data_t));
+    batch->loaded = 0;
+    for (size_t i = 0; i < batch->length; i++){
+        batch_job_t *job = sorted[i];
+        if (i > 0 && strcmp(job->program, sorted[i - 1]->program) == 0){
+            job->loaded = sorted[i - 1]->loaded;
+            job->status = sorted[i - 1]->status;
+            continue;
+        }
 
-    int *memory = calloc(memmax,sizeof(int));
+        bf_data_t *bf_data = batch->programs + batch->loaded++;
+        *bf_data = *template;
+        job->loaded = bf_data;
 
-    while(bf_data->instructions[insptr] != BF_UNDEFINED){
-        switch(bf_data->instructions[insptr]){
-        case BF_INC:
-            insptr++;
-            memory[memptr] += bf_data->instructions[insptr];
-            break;
-        case BF_DEC:
-            insptr++;
-            memory[memptr] -= bf_data->instructions[insptr];
-            break;
-        case BF_NEXT:
-            insptr++;
-            memptr += bf_data->instructions[insptr];
-            if (memptr >= memmax)
-                reallocate_runtime_memory(&memory, &memmax, memptr);
-            break;
-        case BF_PREV:
-            insptr++;
-            memptr -= bf_data->instructions[insptr];
-            break;
-        case BF_LOOP_START:
-            insptr++;
-            if (memory[memptr] == 0){
-                insptr = bf_data->instructions[insptr] + 1;
-            }
-            break;
-        case BF_LOOP_END:
-            insptr++;
-            if (memory[memptr] != 0){
-                insptr = bf_data->instructions[insptr] + 1;
-            }
-            break;
-        case BF_PUT:
-            fputc(memory[memptr],output_file);
-            break;
-        case BF_GET:
-            memory[memptr] = getchar();
-            break;
+        source_t source;
+        int fd = open(job->program, O_RDONLY);
+        job->status = fd == -1 ? STATUS_NO_INPUT : source_open(&source, fd);
+        if (fd != -1)
+            close(fd);
+        if (job->status == STATUS_OK){
+            job->status = bf_data_from_source(bf_data, &source);
+            source_close(&source);
         }
-        insptr++;
+        if (job->status == STATUS_OK)
+            bf_data_optimize(bf_data, steps_max);
     }
 
-    // Free the memory
-    free(memory);
-
-    return STATUS_OK;
+    free(sorted);
 }
 
+// Takes the next job for `worker`, its own or another's; 0 when all are done
+int batch_next (batch_t *batch, int worker, size_t *job)
+{
+    for (int i = 0; i < batch->workers; i++){
+        int from = (worker + i) % batch->workers;
+        batch_queue_t *queue = batch->queues + from;
+        int found = 0;
+        pthread_mutex_lock(&queue->lock);
+        if (queue->front < queue->back){
+            *job = from == worker ? queue->jobs[queue->front++]
+                                  : queue->jobs[--queue->back];
+            found = 1;
+        }
+        pthread_mutex_unlock(&queue->lock);
+        if (found)
+            return 1;
+    }
+    return 0;
+}
 
-int bf_data_through_gcc (bf_data_t *bf_data, char *output_filename)
+// Runs a job of a batch, with `output` as the buffer of the worker
+int batch_run (batch_t *batch, batch_job_t *job, output_t *output)
 {
-    char intermediate_filename[] = "/tmp/XXXXXX.c";
-    int mkstemps_error = mkstemps(intermediate_filename, 2);
+    if (job->status != STATUS_OK)
+        return job->status;
 
-    if (mkstemps_error == -1)
-        return STATUS_CANNOT_CREATE_TEMP_FILE;
-    
-    FILE *intermediate = fopen(intermediate_filename, "w");
+    int input = job->input != NULL ? open(job->input, O_RDONLY) : -1;
+    if (job->input != NULL && input == -1)
+        return STATUS_CANNOT_OPEN_JOB_FILE;
+    int fd = open(job->output, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd == -1){
+        if (input != -1)
+            close(input);
+        return STATUS_CANNOT_OPEN_JOB_FILE;
+    }
 
-    // Open pipes in and out of GCC
-    if(intermediate != NULL) {
+    output_open(output, fd, batch->line_buffered, input);
 
-        // Write to GCC
-        
-        int insptr;
+    int status;
+    bf_slice_t slice = {.budget = batch->quota};
+    sigjmp_buf escape;
+    if (sigsetjmp(escape, 1) == 0){
+        active_escape = &escape;
+        if (batch->quota >= 0)
+            status = bf_data_run_quota(job->loaded, output,
+                                       batch->goal == GOAL_JIT, &slice);
+        else if (batch->goal == GOAL_JIT)
+            status = bf_data_run_jit(job->loaded, output);
+        else if (batch->engine == ENGINE_THREADED)
+            status = bf_data_run_threaded(job->loaded, output);
+        else if (batch->engine == ENGINE_TIERED)
+            status = bf_data_run_tiered(job->loaded, output, &slice);
+        else
+            status = bf_data_run(job->loaded, output);
+    } else {
+        status = STATUS_LEFT_TAPE;
+        slice.memory = NULL; // Given back on the way out
+    }
+    active_escape = NULL;
+    bf_slice_drop(&slice);
 
-        fprintf(intermediate,
-                // Includes
-                "#include <stdlib.h>\n"
-                "#include <stdio.h>\n"
+    output_close(output);
+    close(fd);
+    if (input != -1)
+        close(input);
+    return status;
+}
 
-                // Global variables for memory management
-                "int* memory;"
-                "int memsize=1, memptr=0;"
-
-                // Function for dynamic memory allocation
-                "void memfix(){"
-                "    if(memptr < memsize) return;"
-                "    int oldsize=memsize;"
-                "    while(memptr >= memsize){"
-                "        memsize *= 2;"
-                "    };"
-                "    int * newmem = calloc(memsize,sizeof(int));"
-                "    int i;"
-                "    for(i=0;i<oldsize;i++){"
-                "        newmem[i]=memory[i];"
-                "    }"
-                "    free(memory);memory=newmem;"
-                "}"
+void *batch_work (void *arg)
+{
+    batch_worker_t *worker = arg;
+    batch_t *batch = worker->batch;
+    output_t *output = malloc(sizeof(output_t));
 
-                // Open main
-                "int main(void) {"
-                "    memory = calloc(memsize,sizeof(int));");
+    size_t job;
+    while (batch_next(batch, worker->index, &job))
+        batch->jobs[job].status = batch_run(batch, batch->jobs + job, output);
 
-        // Generate the actual instructions
-        for (insptr = 0;
-             bf_data->instructions[insptr] != BF_UNDEFINED;
-             insptr++) {
-            switch (bf_data->instructions[insptr]) {
-            case BF_INC:
-                insptr++;
-                fprintf(intermediate,"memory[memptr] += %i;\n",
-                        bf_data->instructions[insptr]);
-                break;
-            case BF_DEC:
-                insptr++;
-                fprintf(intermediate,"memory[memptr] -= %i;\n",
-                        bf_data->instructions[insptr]);
-                break;
-            case BF_GET:
-                fprintf(intermediate,"memory[memptr] = getchar();\n");
-                break;
-            case BF_PUT:
-                fprintf(intermediate,"putchar(memory[memptr]);\n");
-                break;
-            case BF_NEXT:
-                insptr++;
-                fprintf(intermediate,"memptr += %i;\n",
-                        bf_data->instructions[insptr]);
-                // memfix is called to make sure the memory is still big enough
-                fprintf(intermediate,"memfix();");
-                break;
-            case BF_PREV:
-                insptr++;
-                fprintf(intermediate,"memptr -= %i;\n",
-                        bf_data->instructions[insptr]);
-                break;
-            case BF_LOOP_START:
-                insptr++;
-                fprintf(intermediate,"while(memory[memptr]!=0){\n");
-                break;
-            case BF_LOOP_END:
-                insptr++;
-                fprintf(intermediate,"}\n");
-                break;
-            }
-        }
+    free(output);
+    guarded_tape_drop_kept();
+    return NULL;
+}
 
-        // Now close main
-        fprintf(intermediate,"}\n");
-        
-        // Close intermediate file
-        fclose(intermediate);
+// What went wrong with a job of a batch
+const char *batch_status_message (int status)
+{
+    switch (status){
+    case STATUS_UNBALANCED_LOOP:
+        return "BF_LOOP_START and BF_LOOP_END were not balanced";
+    case STATUS_LOOP_END_BEFORE_START:
+        return "Encountered BF_LOOP_END before matching BF_LOOP_START";
+    case STATUS_NO_INPUT:
+        return "Could not read the program";
+    case STATUS_CANNOT_OPEN_JOB_FILE:
+        return "Could not open its input or output";
+    case STATUS_LEFT_TAPE:
+        return "The memory pointer left the tape";
+    case STATUS_OVER_QUOTA:
+        return "Went around loops more often than -Q allows";
+    case STATUS_CANNOT_MAP_MEMORY:
+        return "Could not map memory";
+    case STATUS_JIT_UNSUPPORTED:
+        return "Compiling to machine code is not supported on this platform";
+    default:
+        return "Unknown error";
+    }
+}
 
-        // Run gcc on intermediate file
-        execl("/usr/bin/gcc", "gcc", intermediate_filename, "-o", output_filename, NULL); // TODO error handling
+/* Runs the jobs in the manifest `filename` on `workers` threads, each with
+   a tape and output buffer of its own that it keeps using. Every program
+   is loaded and optimized once, before any job runs, as set out by
+   `template` and `steps_max`. Unless `quota` is negative, jobs are held to
+   it like `bf_data_run_quota` does. The jobs are dealt out to the workers in
+   turn, and a worker that is done with its own jobs steals those of
+   others, so a long job does not hold up the ones after it. Jobs that
+   failed are reported on stderr. */
+int bf_data_batch (const char *filename, int workers, int goal, int engine,
+                   const bf_data_t *template, long steps_max, long quota)
+{
+    batch_t batch = {.workers = workers, .goal = goal, .engine = engine,
+                     .line_buffered = template->line_buffered, .quota = quota};
+    int status = batch_read_manifest(&batch, filename);
+    if (status != STATUS_OK)
+        return status;
+    batch_load(&batch, template, steps_max);
 
-        // Remove the intermediate file
-        remove(intermediate_filename);
+    batch.queues = malloc(workers * sizeof(batch_queue_t));
+    for (int w = 0; w < workers; w++){
+        batch_queue_t *queue = batch.queues + w;
+        pthread_mutex_init(&queue->lock, NULL);
+        queue->jobs = malloc((batch.length / workers + 1) * sizeof(size_t));
+        queue->front = queue->back = 0;
+    }
+    for (size_t i = 0; i < batch.length; i++){
+        batch_queue_t *queue = batch.queues + i % workers;
+        queue->jobs[queue->back++] = i;
+    }
 
-        return STATUS_OK;
-    } else {
-        return STATUS_CANNOT_REACH_GCC;
+    // This thread is the first worker, the jobs of any that could not be
+    // started get stolen by the others
+    batch_worker_t *pool = malloc(workers * sizeof(batch_worker_t));
+    for (int w = 0; w < workers; w++){
+        pool[w] = (batch_worker_t) {&batch, w};
+        if (w > 0 && pthread_create(&pool[w].thread, NULL, batch_work, pool + w) != 0)
+            pool[w].batch = NULL;
+    }
+    batch_work(pool);
+    for (int w = 1; w < workers; w++)
+        if (pool[w].batch != NULL)
+            pthread_join(pool[w].thread, NULL);
+
+    size_t failed = 0;
+    for (size_t i = 0; i < batch.length; i++){
+        batch_job_t *job = batch.jobs + i;
+        if (job->status != STATUS_OK){
+            fprintf(stderr, "%s:%zu: %s: %s\n", filename, job->line,
+                    job->program, batch_status_message(job->status));
+            failed++;
+        }
+        free(job->program);
+        free(job->input);
+        free(job->output);
     }
+
+    for (size_t i = 0; i < batch.loaded; i++)
+        free(batch.programs[i].ops);
+    for (int w = 0; w < workers; w++){
+        pthread_mutex_destroy(&batch.queues[w].lock);
+        free(batch.queues[w].jobs);
+    }
+    free(pool);
+    free(batch.queues);
+    free(batch.jobs);
+    free(batch.programs);
+    return failed == 0 ? STATUS_OK : STATUS_COMMAND_FAILED;
+}
+
+// Left out of libfuckedup, which is built with FUCKED_UP_LIBRARY defined
+#ifndef FUCKED_UP_LIBRARY
+// Seconds from `*since` until now, which `*since` is moved on to
+double phase_seconds (struct timespec *since)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double seconds = (now.tv_sec - since->tv_sec)
+        + (now.tv_nsec - since->tv_nsec) / 1e9;
+    *since = now;
+    return seconds;
 }
 
 int main(int argc, char *argv[])
@@ -454,19 +5510,70 @@ int main(int argc, char *argv[])
     int input_mode = READ_STDIN;
     int output_mode = WRITE_STDOUT;
     int goal = GOAL_EVAL;
+    int engine = ENGINE_SWITCH;
+    int opt_level = 2;
+    int native = 0;
+    int bench_runs = 0;
+    int profile_top = 0;
+    long steps_max = CONSTANTS_STEP_MAX;
+    long quota = -1;
+    long workers = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t cell_size = 1;
+    int tape_mode = TAPE_DYNAMIC;
+    int line_buffered = 0;
+    int eof = EOF_MINUS_ONE;
+    int measure = 0;
 
     // In- and output location
     char * input_arg = "";
     char * output_arg = "";
+    char * profile_arg = "";
+    char * batch_arg = "";
+    char * snapshot_arg = "";
 
     // Argument parsing
     int c;
-    while ((c = getopt (argc, argv, "c:f:gho:")) != -1) {
+    while ((c = getopt (argc, argv, "b:B:c:e:E:f:ghjlmnN:o:O:p:P:Q:s:S:t:T:uw:")) != -1) {
         switch (c) {
+        case 'b':
+            batch_arg = optarg;
+            break;
+        case 'B':
+            goal = GOAL_BENCH;
+            bench_runs = atoi(optarg);
+            if (bench_runs < 1){
+                fprintf(stderr, "Number of runs must be at least 1\n");
+                exit(EX_USAGE);
+            }
+            break;
         case 'c':
             input_mode = READ_ARG;
             input_arg = optarg;
             break;
+        case 'e':
+            if (strcmp(optarg, "switch") == 0)
+                engine = ENGINE_SWITCH;
+            else if (strcmp(optarg, "threaded") == 0)
+                engine = ENGINE_THREADED;
+            else if (strcmp(optarg, "tiered") == 0)
+                engine = ENGINE_TIERED;
+            else {
+                fprintf(stderr, "Unknown engine %s\n", optarg);
+                exit(EX_USAGE);
+            }
+            break;
+        case 'E':
+            if (strcmp(optarg, "-1") == 0)
+                eof = EOF_MINUS_ONE;
+            else if (strcmp(optarg, "0") == 0)
+                eof = EOF_ZERO;
+            else if (strcmp(optarg, "unchanged") == 0)
+                eof = EOF_UNCHANGED;
+            else {
+                fprintf(stderr, "End of input must be -1, 0 or unchanged\n");
+                exit(EX_USAGE);
+            }
+            break;
         case 'f':
             input_mode = READ_FILE;
             input_arg = optarg;
@@ -474,12 +5581,126 @@ int main(int argc, char *argv[])
         case 'g':
             goal = GOAL_GCC;
             break;
+        case 'j':
+            goal = GOAL_JIT;
+            break;
+        case 'l':
+            goal = GOAL_LLVM;
+            break;
+        case 't':
+            if (strcmp(optarg, "dynamic") == 0)
+                tape_mode = TAPE_DYNAMIC;
+            else if (strcmp(optarg, "guarded") == 0)
+                tape_mode = TAPE_GUARDED;
+            else {
+                fprintf(stderr, "Unknown tape mode %s\n", optarg);
+                exit(EX_USAGE);
+            }
+            break;
+        case 'n':
+            native = 1;
+            break;
+        case 'N':
+            goal = GOAL_SEQUENCES;
+            profile_top = atoi(optarg);
+            if (profile_top < 1){
+                fprintf(stderr, "Number of sequences must be at least 1\n");
+                exit(EX_USAGE);
+            }
+            break;
+        case 'p':
+            goal = GOAL_PROFILE;
+            profile_top = atoi(optarg);
+            if (profile_top < 1){
+                fprintf(stderr, "Number of loops must be at least 1\n");
+                exit(EX_USAGE);
+            }
+            break;
+        case 'P':
+            profile_arg = optarg;
+            break;
+        case 'Q': {
+            char *end;
+            quota = strtol(optarg, &end, 10);
+            if (*optarg == '\0' || *end != '\0' || quota < 0){
+                fprintf(stderr, "Quota must be 0 or more\n");
+                exit(EX_USAGE);
+            }
+            break;
+        }
+        case 's': {
+            char *end;
+            steps_max = strtol(optarg, &end, 10);
+            if (*optarg == '\0' || *end != '\0' || steps_max < 0){
+                fprintf(stderr, "Number of steps must be 0 or more\n");
+                exit(EX_USAGE);
+            }
+            break;
+        }
+        case 'S':
+            snapshot_arg = optarg;
+            break;
+        case 'T': {
+            char *end;
+            workers = strtol(optarg, &end, 10);
+            if (*optarg == '\0' || *end != '\0' || workers < 1 || workers > 1024){
+                fprintf(stderr, "Number of workers must be 1 to 1024\n");
+                exit(EX_USAGE);
+            }
+            break;
+        }
+        case 'u':
+            line_buffered = 1;
+            break;
+        case 'w':
+            if (strcmp(optarg, "8") == 0)
+                cell_size = 1;
+            else if (strcmp(optarg, "16") == 0)
+                cell_size = 2;
+            else if (strcmp(optarg, "32") == 0)
+                cell_size = 4;
+            else {
+                fprintf(stderr, "Cell width must be 8, 16 or 32\n");
+                exit(EX_USAGE);
+            }
+            break;
+        case 'm':
+            measure = 1;
+            break;
+        case 'O':
+            if (strcmp(optarg, "s") == 0)
+                opt_level = OPT_SIZE;
+            else if (optarg[0] < '0' || optarg[0] > '3' || optarg[1] != '\0'){
+                fprintf(stderr, "Optimization level must be 0 to 3 or s\n");
+                exit(EX_USAGE);
+            } else
+                opt_level = optarg[0] - '0';
+            break;
         case 'h':
             fputs("Usage:\n\n",stderr);
-            fputs("fucked-up [-c CODE | -f INPUT_FILE] [-g] [-o OUTPUT_FILE]\n\n",stderr);
+            fputs("fucked-up [-c CODE | -f INPUT_FILE | -b MANIFEST] [-e ENGINE] [-E EOF] [-B RUNS | -g | -j | -l | -N SEQUENCES | -p LOOPS] [-m] [-n] [-O LEVEL] [-P PROFILE] [-Q QUOTA] [-s STEPS] [-S SNAPSHOT] [-t TAPE] [-T WORKERS] [-u] [-w BITS] [-o OUTPUT_FILE]\n\n",stderr);
+            fputs("-b  Run the jobs in MANIFEST, lines of PROGRAM INPUT OUTPUT files\n",stderr);
+            fputs("-B  Time RUNS runs on every engine, as CSV or JSON (.json)\n",stderr);
             fputs("-c  Read code from following argument\n",stderr);
+            fputs("-e  Interpret using ENGINE, `switch` (default), `threaded` or `tiered`\n",stderr);
+            fputs("-E  At the end of input store -1 (default), 0 or leave cells `unchanged`\n",stderr);
             fputs("-f  Read code from specified file\n",stderr);
             fputs("-g  Compile using GCC, using C as intermediate language\n",stderr);
+            fputs("-j  Compile to machine code in memory and run it (x86-64 only)\n",stderr);
+            fputs("-l  Compile using LLVM, to IR (.ll), an object file (.o) or an executable\n",stderr);
+            fputs("-m  Write how long reading, parsing, optimizing and running took to stderr\n",stderr);
+            fputs("-n  Compile for the CPU of this machine only (-march=native)\n",stderr);
+            fputs("-N  Interpret, then list the SEQUENCES most run instruction sequences on stderr\n",stderr);
+            fputs("-O  Optimization level for GCC and LLVM, 0 to 3 or s for size (default 2)\n",stderr);
+            fputs("-p  Interpret, then list the LOOPS hottest loops on stderr\n",stderr);
+            fputs("-P  Write the profile made by -p to PROFILE, or compile by it\n",stderr);
+            fputs("-Q  Stop programs that go around loops more than QUOTA times\n",stderr);
+            fputs("-s  Run the program for up to STEPS while compiling (default 2^20)\n",stderr);
+            fputs("-S  Start from SNAPSHOT, or take it where the program first reads input\n",stderr);
+            fputs("-t  Interpret on a `dynamic` (default) or `guarded` tape\n",stderr);
+            fputs("-T  Run -b jobs on WORKERS threads (default one per CPU)\n",stderr);
+            fputs("-u  Write output at every newline, as is done for a terminal\n",stderr);
+            fputs("-w  Bits per cell, 8 (default), 16 or 32\n",stderr);
             fputs("-o  Write to specified file\n",stderr);
             exit(EX_USAGE);
             break;
@@ -492,29 +5713,80 @@ int main(int argc, char *argv[])
         }
     }
 
+    // Snapshots are of runs on a guarded tape
+    if (*snapshot_arg != '\0'){
+        if (goal != GOAL_EVAL && goal != GOAL_JIT){
+            fputs("Snapshots are of runs on the interpreter or with -j only\n", stderr);
+            exit(EX_USAGE);
+        }
+        if (*batch_arg != '\0'){
+            fputs("Batches do not take snapshots\n", stderr);
+            exit(EX_USAGE);
+        }
+        tape_mode = TAPE_GUARDED;
+    }
+
+    // Pick the fastest scan kernels for this CPU
+    scan_select();
+
     // Create empty bf_data and initialize
-    bf_data_t bf_data = {calloc(0,sizeof(int))};
+    bf_data_t bf_data = {NULL, 0, cell_size, tape_mode, line_buffered, eof, NULL, 0};
+
+    // Batches load their programs themselves, and run them like this one
+    if (*batch_arg != '\0'){
+        if (goal != GOAL_EVAL && goal != GOAL_JIT){
+            fputs("Batches run on the interpreters or with -j only\n", stderr);
+            exit(EX_USAGE);
+        }
+        switch (bf_data_batch(batch_arg, workers, goal, engine, &bf_data, steps_max, quota)){
+        case STATUS_CANNOT_READ_MANIFEST:
+            fprintf(stderr, "Could not read manifest %s\n", batch_arg);
+            exit(EX_NOINPUT);
+        case STATUS_COMMAND_FAILED:
+            exit(EX_SOFTWARE);
+        }
+        return 0;
+    }
+
+    // Profiles need to know where the instructions came from
+    if (goal == GOAL_PROFILE)
+        bf_data.positions = malloc(sizeof(bf_position_t));
 
     // Status so far
     int status = STATUS_OK;
 
-    FILE * input_file;
+    source_t source;
     FILE * output_file;
+    static output_t output;
+
+    // Benchmarks run tests/mandelbrot.bf unless told otherwise
+    if (goal == GOAL_BENCH && input_mode == READ_STDIN){
+        input_mode = READ_FILE;
+        input_arg = "tests/mandelbrot.bf";
+    }
+
+    // Reading, parsing, optimizing and running are timed for -m
+    struct timespec phase_start;
+    double read_seconds = 0, parse_seconds = 0, optimize_seconds = 0;
+    clock_gettime(CLOCK_MONOTONIC, &phase_start);
 
     // Open input and output files depending on the input_mode and output_mode
     switch(input_mode) {
     case READ_ARG:
-        input_file = fmemopen(input_arg,strlen(input_arg),"r");
+        source = (source_t) {input_arg, strlen(input_arg), NULL, NULL};
         break;
-    case READ_FILE:
-        input_file = fopen(input_arg, "r");
-        if (input_file == NULL){
+    case READ_FILE: {
+        int input_fd = open(input_arg, O_RDONLY);
+        if (input_fd == -1){
             perror("Could not read input file");
             exit(EX_NOINPUT);
         }
+        status = source_open(&source, input_fd);
+        close(input_fd);
         break;
+    }
     case READ_STDIN:
-        input_file = stdin;
+        status = source_open(&source, STDIN_FILENO);
         break;
     default:
         fprintf(stderr, "Internal error, no `input_mode`");
@@ -523,7 +5795,7 @@ int main(int argc, char *argv[])
 
     switch(output_mode) {
     case WRITE_FILE:
-        if (goal != GOAL_GCC){
+        if (goal != GOAL_GCC && goal != GOAL_LLVM){
             output_file = fopen(output_arg, "w");
             if (output_file == NULL) {
                 perror("Could not read output file");
@@ -541,9 +5813,14 @@ int main(int argc, char *argv[])
         exit(EX_SOFTWARE);
     }
 
-    // Read data from file and close
-    bf_data_from_file(&bf_data,input_file);
-    fclose(input_file);
+    read_seconds = phase_seconds(&phase_start);
+
+    // Read the program into compressed instruction space and close
+    if (status == STATUS_OK){
+        status = bf_data_from_source(&bf_data, &source);
+        source_close(&source);
+    }
+    parse_seconds = phase_seconds(&phase_start);
 
     // Error if something went wrong
     switch (status){
@@ -567,24 +5844,76 @@ int main(int argc, char *argv[])
         exit(EX_SOFTWARE);
     }
 
-    // Compress the program
-    compress(&bf_data);
+    // Optimize instruction space for running or compiling
+    bf_data_optimize(&bf_data, steps_max);
+
+    // Mark hot and cold loops by an earlier profile of the same program
+    if (goal != GOAL_PROFILE && *profile_arg != '\0'
+        && profile_apply(&bf_data, profile_arg) != STATUS_OK){
+        fprintf(stderr, "Could not read profile %s\n", profile_arg);
+        exit(EX_NOINPUT);
+    }
+    optimize_seconds = phase_seconds(&phase_start);
+
+    // Programs that are run write to the output through `output`
+    output_open(&output, fileno(output_file),
+                line_buffered || isatty(fileno(output_file)), STDIN_FILENO);
 
     // Do specified job on the code, writing to specified output
+    bf_slice_t slice = {.budget = quota};
     switch (goal) {
     case GOAL_EVAL:
-        // Run the program
-        status = bf_data_run (&bf_data, output_file);
+    case GOAL_JIT:
+        // Run the program, stopping it at the quota if there is one
+        if (*snapshot_arg != '\0'){
+            slice.budget = quota >= 0 ? quota : LONG_MAX;
+            status = bf_data_run_snapshot(&bf_data, &output, goal == GOAL_JIT,
+                                          &slice, snapshot_arg);
+            bf_slice_drop(&slice);
+        } else if (quota >= 0){
+            status = bf_data_run_quota(&bf_data, &output, goal == GOAL_JIT, &slice);
+            bf_slice_drop(&slice);
+        } else if (goal == GOAL_JIT)
+            status = bf_data_run_jit (&bf_data, &output);
+        else if (engine == ENGINE_THREADED)
+            status = bf_data_run_threaded (&bf_data, &output);
+        else if (engine == ENGINE_TIERED){
+            status = bf_data_run_tiered (&bf_data, &output, &slice);
+            bf_slice_drop(&slice);
+        } else
+            status = bf_data_run (&bf_data, &output);
         break;
     case GOAL_GCC:
-        // Compile with GCC
-        status = bf_data_through_gcc (&bf_data, output_arg);
+    case GOAL_LLVM:
+        // Compile with GCC or LLVM, or take what they made before
+        status = bf_data_through_cache (&bf_data, goal, output_arg, opt_level, native);
+        break;
+    case GOAL_PROFILE:
+        // Run the program, counting how often each instruction runs
+        status = bf_data_profile (&bf_data, &output, profile_top, profile_arg);
+        break;
+    case GOAL_SEQUENCES:
+        // Run the program, counting how often each instruction runs
+        status = bf_data_sequences (&bf_data, &output, profile_top);
+        break;
+    case GOAL_BENCH:
+        // Time every engine, writing the report instead of program output
+        status = bf_data_bench (&bf_data, bench_runs, opt_level, native,
+                                output_file, has_suffix(output_arg, ".json"));
         break;
     }
 
     // Close output
+    output_close(&output);
     fclose(output_file);
 
+    /* Compressing runs of instructions is part of parsing, and compiling
+       with -g or -l of running */
+    if (measure)
+        fprintf(stderr, "Phases: read %.6f s, parse %.6f s, optimize %.6f s, "
+                "run %.6f s\n", read_seconds, parse_seconds, optimize_seconds,
+                phase_seconds(&phase_start));
+
     // If the goal was to make an executable file, chmod it
     if (goal == GOAL_GCC && output_mode == WRITE_FILE)
         chmod (output_arg, 0775);
@@ -595,8 +5924,40 @@ int main(int argc, char *argv[])
         perror("Could not reach GCC");
         exit(EX_SOFTWARE);
         break;
+    case STATUS_CANNOT_REACH_LLVM:
+        perror("Could not reach LLVM");
+        exit(EX_SOFTWARE);
+        break;
+    case STATUS_LLVM_TOO_NEW:
+        fprintf(stderr, "Compiling through LLVM needs LLVM %d or older\n", LLVM_NEWEST);
+        exit(EX_UNAVAILABLE);
+        break;
+    case STATUS_COMMAND_FAILED:
+        exit(EX_SOFTWARE);
+        break;
+    case STATUS_CANNOT_CREATE_TEMP_FILE:
+        perror("Could not create temporary file");
+        exit(EX_CANTCREAT);
+        break;
+    case STATUS_JIT_UNSUPPORTED:
+        fputs("Compiling to machine code is not supported on this platform\n",stderr);
+        exit(EX_UNAVAILABLE);
+        break;
+    case STATUS_CANNOT_MAP_MEMORY:
+        perror("Could not map memory");
+        exit(EX_OSERR);
+        break;
+    case STATUS_CANNOT_WRITE_PROFILE:
+        perror("Could not write profile");
+        exit(EX_CANTCREAT);
+        break;
+    case STATUS_OVER_QUOTA:
+        fprintf(stderr, "Program went around loops more than %ld times\n", quota);
+        exit(EX_SOFTWARE);
+        break;
     case STATUS_OK:
         // No problem
         break;
     }
 }
+#endif
@@ -0,0 +1,119 @@
+/* Copyright (C) 2017-2024 Lambdara
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+/* libfuckedup, the interpreter of fucked-up as a library: programs are
+   compiled once, then run as often as needed on a context, which holds
+   the tape given by the caller. Running allocates no memory. A context is
+   used by one thread at a time, different contexts can be used at once. */
+
+#ifndef FUCKED_UP_H
+#define FUCKED_UP_H
+
+#include <stddef.h>
+
+#define FUCKED_UP_API __attribute__((visibility("default")))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Results of the functions below
+enum {
+    FUCKED_UP_OK = 0,
+    FUCKED_UP_UNBALANCED_LOOP,   // Compiling: a [ or ] without its match
+    FUCKED_UP_LEFT_TAPE,         // Running: the memory pointer left the tape
+    FUCKED_UP_OUTPUT_TOO_LARGE,  // Running: output did not fit, see below
+    FUCKED_UP_INVALID,           // Bad argument, or out of memory
+    FUCKED_UP_SUSPENDED,         // Running: used up its budget, see below
+    FUCKED_UP_NEEDS_INPUT,       // Running: waiting for input, see below
+};
+
+// What a program reading past the end of its input gets, see below
+enum {
+    FUCKED_UP_EOF_MINUS_ONE = 0, // The cell is set to all ones
+    FUCKED_UP_EOF_ZERO,          // The cell is set to 0
+    FUCKED_UP_EOF_UNCHANGED,     // The cell is left as it was
+};
+
+typedef struct fucked_up_program fucked_up_program_t;
+typedef struct fucked_up_context fucked_up_context_t;
+
+/* Compiles the `length` bytes of `source`, for cells of `cell_bits` 8, 16
+   or 32, with `eof` one of FUCKED_UP_EOF_*. Returns NULL on failure, with
+   the reason in `status` if that is not NULL. */
+FUCKED_UP_API fucked_up_program_t *
+fucked_up_compile (const char *source, size_t length, int cell_bits, int eof,
+                   int *status);
+
+FUCKED_UP_API void fucked_up_program_free (fucked_up_program_t *program);
+
+/* Makes a context for running programs on the `tape_size` bytes at
+   `tape`, which it leaves to the caller. Returns NULL on failure. */
+FUCKED_UP_API fucked_up_context_t *
+fucked_up_context_new (void *tape, size_t tape_size);
+
+FUCKED_UP_API void fucked_up_context_free (fucked_up_context_t *context);
+
+/* Reads up to `size` bytes of input into `buffer`. Returns how many it
+   read, 0 at the end of input, or -1 if there is none yet. */
+typedef long fucked_up_read_t (void *user, void *buffer, size_t size);
+
+/* Has programs run on `context` go on reading input from `read`, called
+   with `user`, once the input handed to fucked_up_run(_for) is used up;
+   NULL, the default, ends input there. When `read` has no input yet, the
+   run is suspended like fucked_up_run_for does, with FUCKED_UP_NEEDS_INPUT
+   instead, to be resumed once it does. */
+FUCKED_UP_API void
+fucked_up_context_input (fucked_up_context_t *context, fucked_up_read_t *read,
+                         void *user);
+
+/* Runs `program` on a cleared tape of `context`, reading input from the
+   `input_length` bytes at `input` (EOF after them) and writing output to
+   the `output_size` bytes at `output`. The number of bytes written is
+   stored in `output_length`; when that is more than `output_size` the
+   rest was lost, and FUCKED_UP_OUTPUT_TOO_LARGE is returned. */
+FUCKED_UP_API int
+fucked_up_run (const fucked_up_program_t *program, fucked_up_context_t *context,
+               const void *input, size_t input_length,
+               void *output, size_t output_size, size_t *output_length);
+
+/* Like fucked_up_run, but once the program went back to the start of a
+   loop `budget` times it stops before doing so again, returning
+   FUCKED_UP_SUSPENDED. The run is then kept in `context`, input, output
+   and all, for fucked_up_resume to go on with it for another `budget`;
+   until it ends, `program` and the memory handed to this have to stay.
+   `output_length` is the output of the run so far. Running anything else
+   on the context drops the run. This way a thread can take turns running
+   many programs, or hold them to a limit, and the counting of how often
+   loops go around is all it costs. */
+FUCKED_UP_API int
+fucked_up_run_for (const fucked_up_program_t *program,
+                   fucked_up_context_t *context,
+                   const void *input, size_t input_length,
+                   void *output, size_t output_size, long budget,
+                   size_t *output_length);
+
+FUCKED_UP_API int
+fucked_up_resume (fucked_up_context_t *context, long budget,
+                  size_t *output_length);
+
+// Describes a result of the functions above
+FUCKED_UP_API const char *fucked_up_status_message (int status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,20 @@
+/* Superinstructions of `bf_data_run_threaded`, as made by `make
+   superinstructions`: NAME, LENGTH and the opcodes of each */
+#define SUPERINSTRUCTIONS(X, ...) \
+    X(add_add, 2, ADD, ADD, END, __VA_ARGS__) \
+    X(clear_clear, 2, CLEAR, CLEAR, END, __VA_ARGS__) \
+    X(clear_clear_clear, 3, CLEAR, CLEAR, CLEAR, __VA_ARGS__) \
+    X(add_add_add, 3, ADD, ADD, ADD, __VA_ARGS__) \
+    X(add_loop_end, 2, ADD, LOOP_END, END, __VA_ARGS__) \
+    X(move_loop_end, 2, MOVE, LOOP_END, END, __VA_ARGS__) \
+    X(clear_add, 2, CLEAR, ADD, END, __VA_ARGS__) \
+    X(move_loop_start, 2, MOVE, LOOP_START, END, __VA_ARGS__) \
+    X(add_move, 2, ADD, MOVE, END, __VA_ARGS__) \
+    X(set_set, 2, SET, SET, END, __VA_ARGS__) \
+    X(set_set_set, 3, SET, SET, SET, __VA_ARGS__) \
+    X(clear_add_add, 3, CLEAR, ADD, ADD, __VA_ARGS__) \
+    X(add_move_loop_end, 3, ADD, MOVE, LOOP_END, __VA_ARGS__) \
+    X(add_move_loop_start, 3, ADD, MOVE, LOOP_START, __VA_ARGS__) \
+    X(loop_end_move, 2, LOOP_END, MOVE, END, __VA_ARGS__) \
+    X(loop_start_clear, 2, LOOP_START, CLEAR, END, __VA_ARGS__) \
+
@@ -0,0 +1,23 @@
+Loops that change their counter by other odd amounts than minus one go
+around as often as modular arithmetic on the cells says so each is run
+as a single multiply and add and writes a letter with the counters
+read from input so they are not known while compiling
+
+Nine down by three goes around three times
+,[--->+<]>++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++.[-]<
+
+Five down by three wraps around the cell
+,[--->+<]>.[-]<
+
+Two up by one wraps around and adds to two cells
+,[+>++>+++<<]>++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++.[-]<>>++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++.[-]<<
+
+Seven up by five adds to a cell two to the right
+,[+++++>>++<<]>>++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++.[-]<<
+
+Three up by seven when some of it cancels out on another cell
+,[+++++++>+++<->-<+]>---------------------------------------------------------------------------------------------------.[-]<
+
+Clearing seven by three and five by minus five always ends so this is a
+newline
+,[---],[+++++]++++++++++.
@@ -0,0 +1,16 @@
+Works out what does not depend on the input while compiling
+[ never runs at the start ]
+++++++[>++++++++++<-]>+++++  sixty five from a loop
+.+.+.                        ABC
+[-]++++++++++.               newline
+[-][ never runs after a clear ]
+,                            reads a
+>+++[<+>-]<                  adds three to it
+.                            d
+>++<[>+<-]>                  adds it to two
+.                            f
+<,                           reads the newline
+[>+<--]                      loop that depends on the input
+[ never runs after a loop ]
+>.                           k
+<++++++++++.                 newline
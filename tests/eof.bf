@@ -0,0 +1,7 @@
+Writes what reading past the end of input leaves in a cell holding 7
+as that plus 49 so 0 for minus one and 1 for zero as cells wrap at any
+width and 8 if it is left unchanged
+
++++++++,
+>++++++[<++++++++>-]<+.
+[-]++++++++++.
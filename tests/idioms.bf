@@ -0,0 +1,19 @@
+Exercises the loop idioms the peephole pass recognises
+
+Multiply loops: 8 times 8 plus 1 gives 'A' in two cells
+++++++++[->++++++++>++++++++<<]>+.>++.<
+Clear loops
+[-]>[-]<
+Multiply loop with negative offset and factor 3 into a zeroed neighbour
+>>+++++++++++[-<<+++>>]<<.
+Newline via multiply then clear
+>[-]++++++++++.[-]<[-]
+Scan right across a run of nonzero cells then back again
+>+>+>+<<<
+>[>]+++++++++++++++++++++++++++++++++++++++++++++++++.[-]
+<[<]
+Strided scans
+>>[>>]++++++++++++++++++++++++++++++++++++++++++++++++++.[-]
+<<[<<]>>>>>>>>>+++++++++++++++++++++++++++++++++++++++++++++++++++.[-]
+Leave a newline
+++++++++++.
@@ -0,0 +1,106 @@
+/* Runs programs through libfuckedup, for `make tests-library`. Every run
+   goes on the same context, which is what the library is meant for. */
+
+#include <stdio.h>
+#include <string.h>
+#include "../fucked-up.h"
+
+static unsigned char tape[30000];
+static char output[1 << 16];
+
+// Compiles and runs `code` with `input`, printing its output and result
+static void run (fucked_up_context_t *context, const char *code,
+                 const char *input, size_t output_size)
+{
+    int status;
+    fucked_up_program_t *program = fucked_up_compile(code, strlen(code), 8,
+                                                     FUCKED_UP_EOF_MINUS_ONE, &status);
+    if (program == NULL){
+        printf("compile: %s\n", fucked_up_status_message(status));
+        return;
+    }
+
+    size_t length;
+    status = fucked_up_run(program, context, input, strlen(input),
+                           output, output_size, &length);
+    fwrite(output, 1, length < output_size ? length : output_size, stdout);
+    printf("run: %s, %zu bytes\n", fucked_up_status_message(status), length);
+    fucked_up_program_free(program);
+}
+
+/* Runs `code` like `run`, `budget` back edges at a time, resuming it at
+   most `slices` times. Prints how many slices it took. */
+static void run_sliced (fucked_up_context_t *context, const char *code,
+                        const char *input, long budget, int slices)
+{
+    fucked_up_program_t *program = fucked_up_compile(code, strlen(code), 8,
+                                                     FUCKED_UP_EOF_ZERO, NULL);
+    size_t length;
+    int status = fucked_up_run_for(program, context, input, strlen(input),
+                                   output, sizeof(output), budget, &length);
+    int slice = 1;
+    for (; status == FUCKED_UP_SUSPENDED && slice <= slices; slice++)
+        status = fucked_up_resume(context, budget, &length);
+    fwrite(output, 1, length, stdout);
+    printf("run: %s, %zu bytes in %d slices\n",
+           fucked_up_status_message(status), length, slice);
+    fucked_up_program_free(program);
+}
+
+/* Input that comes a byte at a time, with none yet every other time it
+   is asked for */
+static const char *typed = "typed\n";
+static int asked;
+
+static long type (void *user, void *buffer, size_t size)
+{
+    (void) user;
+    if (asked++ % 2 == 0)
+        return -1;
+    if (*typed == '\0')
+        return 0;
+    *(char *) buffer = *typed++;
+    return 1;
+}
+
+int main (void)
+{
+    fucked_up_context_t *context = fucked_up_context_new(tape, sizeof(tape));
+
+    // Known output, a line that gets echoed and a loop that depends on input
+    run(context, "++++++++[>++++++++<-]>+.+.+.[-]++++++++++.", "", sizeof(output));
+    run(context, ",----------[++++++++++.,----------]++++++++++.", "echo\n", sizeof(output));
+    run(context, ",[>+<-]>[>+>+<<-]>.>.[-]++++++++++.", "A", sizeof(output));
+    // Tapes are cleared between runs
+    run(context, ">>>>>++++++++++[<++++++>-]<+++++.[-]++++++++++.", "", sizeof(output));
+    // Errors
+    run(context, "+[", "", sizeof(output));
+    run(context, ",[<]", "x", sizeof(output));
+    run(context, ",[>,]", "x", sizeof(output));
+    run(context, ",[.]", "x", 10);
+
+    // Runs in slices, one that ends and one that is dropped by the next run
+    run_sliced(context, ",----------[++++++++++.,----------]++++++++++.",
+               "slices\n", 1, 100);
+    run_sliced(context, "+[>+<]", "", 1000, 3);
+    run(context, "++++++++[>++++++++<-]>+.+.+.[-]++++++++++.", "", sizeof(output));
+
+    // Input that has to be waited for, given at first and then read
+    fucked_up_context_input(context, type, NULL);
+    int waits = 0;
+    size_t length;
+    fucked_up_program_t *program = fucked_up_compile(",[.,]", 5, 8,
+                                                     FUCKED_UP_EOF_ZERO, NULL);
+    int status = fucked_up_run_for(program, context, "I ", 2, output,
+                                   sizeof(output), 100, &length);
+    for (; status == FUCKED_UP_NEEDS_INPUT; waits++)
+        status = fucked_up_resume(context, 100, &length);
+    fwrite(output, 1, length, stdout);
+    printf("run: %s, %zu bytes after %d waits\n",
+           fucked_up_status_message(status), length, waits);
+    fucked_up_program_free(program);
+    fucked_up_context_input(context, NULL, NULL);
+
+    fucked_up_context_free(context);
+    return 0;
+}
@@ -0,0 +1,8 @@
+Runs of output that get written together
+
+Cells with 'x' 'y' and a newline
+++++++++++[>++++++++++++>++++++++++++>+<<<-]>>+>
+Each cell once; then the first one 300 times which takes more than one run
+<<.>.>.<<
+............................................................................................................................................................................................................................................................................................................
+>>.<.
@@ -0,0 +1,2 @@
+Copies its input to its output byte by byte: as with -1 at the end of input
+,+[-.,+]
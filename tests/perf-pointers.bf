@@ -0,0 +1,13 @@
+Walks a tape of 30600 cells back and forth 3000 times: one cell at a
+time and with scans; then writes ok
+
+Cell 0 counts outer rounds and cell 1 inner ones; cell 2 stays 0 before the
+ones that are walked over; which are made 255 at a time
+>>>-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]-[[->+<]+>-]
+<[<]<<
+++++++++++++++++++++++++++++++++++++++++++++++++++[>
+  ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++[
+    >>[+>]<[-<]>[>]<[<]<-
+  ]
+<-]
+++++++++++[>++++++++++<-]>+++++++++++.----.[-]++++++++++.
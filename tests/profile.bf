@@ -0,0 +1,12 @@
+Reads eight and prints ABC with a newline after it from nested loops
+,
+[
+    >++++++++ eight more
+    [>+<-]    multiply into the next cell
+    <-
+]
+>[-]+>+ set up A
+[>+>+<<-]>>[<<+>>-] copy it
+<<<
+++[>>.+<<-] three letters
+>>>>++++++++++.
@@ -0,0 +1,40 @@
+Scans over long runs of nonzero cells with strides 1 2 3 4 8 and 16
+then back again; each scan is checked by printing a letter where it stops
+
+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+>+<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+>[>]
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++.[-]
+<[<]
+>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]>[-]<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+>>+<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+>>[>>]
+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++.[-]
+<<[<<]
+>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]>>[-]<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+>>>+<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+>>>[>>>]
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++.[-]
+<<<[<<<]
+>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]>>>[-]<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+>>>>+<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+>>>>[>>>>]
+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++.[-]
+<<<<[<<<<]
+>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]>>>>[-]<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+>>>>>>>>+<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+>>>>>>>>[>>>>>>>>]
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++.[-]
+<<<<<<<<[<<<<<<<<]
+>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]>>>>>>>>[-]<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+>>>>>>>>>>>>>>>>+<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+>>>>>>>>>>>>>>>>[>>>>>>>>>>>>>>>>]
+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++.[-]
+<<<<<<<<<<<<<<<<[<<<<<<<<<<<<<<<<]
+>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]>>>>>>>>>>>>>>>>[-]<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+++++++++++.[-]
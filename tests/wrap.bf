@@ -0,0 +1,10 @@
+Prints Y if cells wrap around at 8 bits and N if they are wider
+
+>++++++++[>+++++++++++<-]>+
+<<
+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+[>>-----------<<[-]]>>.
+[-]++++++++++.